@@ -0,0 +1,49 @@
+/* Arena (bump) allocator. Memory is carved sequentially out of large blocks and
+ * is only released all at once, which makes many small allocations that share
+ * a lifetime cheap to create and trivial to free.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct arena_block
+{
+    struct arena_block *next;
+    size_t size; // Usable bytes following the header
+    size_t used;
+};
+
+struct arena
+{
+    struct arena_block *head; // Block currently being filled
+    size_t block_size;        // Default usable size of new blocks
+
+    // Statistics
+    size_t bytes_allocated; // Bytes handed out, including alignment padding
+    size_t bytes_reserved;  // Usable bytes of all blocks
+    unsigned int num_allocations;
+    unsigned int num_blocks;
+};
+
+/* Initialize an empty arena. Blocks of `block_size` bytes are allocated as
+ * needed; larger requests get a block of their own
+ */
+void arena_init(struct arena *arena, size_t block_size);
+
+/* Allocate `size` bytes, aligned for any fundamental type. Returns NULL upon
+ * memory allocation error
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/* Print allocation statistics of the arena, labelled with `name`
+ */
+void arena_print_stats(const struct arena *arena, const char *name);
+
+/* Free every block of the arena, invalidating all memory allocated from it
+ */
+void arena_destroy(struct arena *arena);
+
+#endif // ARENA_H
@@ -8,6 +8,7 @@
 #ifndef ASTRO_H
 #define ASTRO_H
 
+#include <stdbool.h>
 #include <time.h>
 
 // For our purposes, the Sun is treated the same as a planet
@@ -57,6 +58,22 @@ struct kep_extra
     double f;
 };
 
+/* Rotation from an orbital plane to equatorial ICRF coordinates, cached for a
+ * body between calls. It depends only on the argument of periapsis, the
+ * longitude of the ascending node and the inclination, which drift slowly, so
+ * their sines and cosines are only evaluated when they have drifted far from
+ * the last evaluation; in between they are rotated by the drift with a short
+ * series. The rotation from the ecliptic to the equator by the J2000 obliquity
+ * is folded in
+ */
+struct orbit_rotation
+{
+    bool valid;
+    double w, O, I; // Angles at which the sines and cosines were evaluated (rad)
+    double sin_w, cos_w, sin_O, cos_O, sin_I, cos_I;
+    double matrix[3][2]; // Orbital plane x and y to equatorial x, y and z
+};
+
 // Dates and times
 
 /* Calculate the greenwich mean sidereal time in radians given a julian date.
@@ -83,12 +100,29 @@ double current_julian_date(void);
 void calc_star_position(double right_ascension, double ra_motion, double declination, double dec_motion, double julian_date,
                         double *ITRF_right_ascension, double *ITRF_declination);
 
+/* Solve Kepler's equation M = E - e sin(E) for the eccentric anomaly E of
+ * `count` orbits at once, e.g. many bodies or many epochs of one body, with
+ * angles in radians and eccentricities below 1. The sine and cosine of each E
+ * are returned too, since positions are built from them. Orbits are iterated
+ * together with AVX2 or SSE2 where available, until all have converged
+ */
+void solve_kepler_batch(const double *M, const double *e, unsigned int count, double *E, double *sin_E, double *cos_E);
+
 /* Calculate the heliocentric ICRF position of a planet in rectangular
  * equatorial coordinates
  */
 void calc_planet_helio_ICRF(const struct kep_elems *elements, const struct kep_rates *rates, const struct kep_extra *extras,
                             double julian_date, double *xh, double *yh, double *zh);
 
+/* Calculate the heliocentric ICRF positions of a planet at `count` times, as
+ * calc_planet_helio_ICRF does for one. Kepler's equation is solved for many
+ * epochs at once. If `rotation` is not NULL, the planet's orbital rotation is
+ * kept there for later calls; it must be zeroed before first use
+ */
+void calc_planet_helio_ICRF_epochs(const struct kep_elems *elements, const struct kep_rates *rates,
+                                   const struct kep_extra *extras, const double *julian_dates, unsigned int count,
+                                   struct orbit_rotation *rotation, double *xh, double *yh, double *zh);
+
 /* Calculate the geocentric ICRF position of a planet in rectangular
  * equatorial coordinates
  */
@@ -97,10 +131,11 @@ void calc_planet_geo_ICRF(double xe, double ye, double ze, const struct kep_elem
                           double *xg, double *yg, double *zg);
 
 /* Calculate the geocentric ICRF position of the Moon in rectangular
- * equatorial coordinates
+ * equatorial coordinates. If `rotation` is not NULL, the Moon's orbital
+ * rotation is kept there for later calls; it must be zeroed before first use
  */
 void calc_moon_geo_ICRF(const struct kep_elems *moon_elements, const struct kep_rates *moon_rates, double julian_date,
-                        double *xg, double *yg, double *zg);
+                        struct orbit_rotation *rotation, double *xg, double *yg, double *zg);
 
 // Miscellaneous
 
@@ -43,6 +43,37 @@
 #ifndef COORD_H
 #define COORD_H
 
+// FRAME TRANSFORM
+
+/* Rotation from rectangular equatorial coordinates to rectangular horizontal
+ * coordinates for a given instant and observer. Rows of the matrix are the
+ * observer's North, East, and zenith directions expressed in the equatorial
+ * frame. Build once per frame with frame_transform_init and share it between
+ * all objects being positioned
+ */
+struct frame_transform
+{
+    double matrix[3][3];
+};
+
+/* Build the equatorial to horizontal rotation from the Greenwich mean sidereal
+ * time and the observer's latitude and longitude
+ */
+void frame_transform_init(struct frame_transform *transform, double gmst, double latitude, double longitude);
+
+/* Converts rectangular equatorial coordinates to horizontal coordinates. The
+ * input vector need not be normalized
+ */
+void frame_transform_apply(const struct frame_transform *transform, double xeq, double yeq, double zeq, double *azimuth,
+                           double *altitude);
+
+/* Converts `count` equatorial unit vectors, given as separate x, y, and z
+ * arrays, to horizontal coordinates. The rotation is vectorized where the
+ * target supports it, leaving a single asin and atan2 per vector
+ */
+void frame_transform_unit_vectors(const struct frame_transform *transform, const double *x, const double *y,
+                                  const double *z, unsigned int count, double *azimuth, double *altitude);
+
 // CONVERSIONS
 
 /* Converts equatorial coordinates (global) to horizontal coordinates (local)
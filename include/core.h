@@ -4,10 +4,12 @@
 #ifndef CORE_H
 #define CORE_H
 
+#include "arena.h"
 #include "astro.h"
 #include "parse_BSC5.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 /* Describes how objects should be rendered
@@ -26,6 +28,19 @@ struct conf
     bool color_flag;
     bool grid_flag;
     bool constell_flag;
+    double pm_interval;
+    int threads;
+    bool pipeline_flag;
+    const char *catalog_path;
+    bool alloc_stats_flag;
+    bool vt_flag;
+    double max_bandwidth;
+    bool skip_idle_flag;
+    const char *export_path;
+    const char *export_end_string_utc;
+    double export_end_julian_date;
+    double export_step; // Days between exported dates
+    bool export_binary_flag;
 };
 
 // All information pertinent to rendering a celestial body
@@ -35,21 +50,36 @@ struct object_base
     double altitude;
     int color_pair; // 0 indicates no color pair
     char symbol_ASCII;
-    char *symbol_unicode;
-    char *label;
+    const char *symbol_unicode; // Shared, never owned by the object
+    const char *label;
 };
 
 struct star
 {
     struct object_base base;
     int catalog_number;
-    double right_ascension;
-    double declination;
-    double ra_motion;
-    double dec_motion;
     float magnitude;
 };
 
+/* Compact catalog record holding a star's J2000 position, proper motion and
+ * magnitude in fixed point, 16 bytes per star. Catalogs are stored in this form
+ * and the position kernel is built from it, while struct star only carries
+ * what is needed for rendering. Stars with catalog number `n` are at index
+ * `n-1` of a packed table.
+ *
+ * Angles resolve to about 1.5e-9 radians and proper motions to about 3.7e-9
+ * radians per year, well below anything that can be displayed
+ */
+struct packed_star
+{
+    uint32_t right_ascension; // Fraction of a full turn, in units of 2^-32
+    int32_t declination;      // Fraction of half a turn, in units of 2^-31
+    int16_t ra_motion;        // Radians per Julian year, in units of 2^-28
+    int16_t dec_motion;
+    int16_t magnitude; // Hundredths of a magnitude, as in BSC5
+    uint16_t symbol;   // Index into the shared table of star symbols
+};
+
 struct planet
 {
     struct object_base base;
@@ -73,41 +103,140 @@ struct constell
     int *star_numbers;
 };
 
-struct star_name
+/* Spatial index over the slots of a star_soa. The sky is divided into cells
+ * bounded by declination bands and right ascension sectors, and the SoA is
+ * reordered so that each cell's stars occupy a contiguous range of slots. Each
+ * cell is bounded by a cap around its center that contains all of its stars,
+ * so a whole cell can be skipped whenever the cap lies below the horizon.
+ *
+ * The last cell holds stars that must always be positioned (e.g. constellation
+ * figure stars, whose off-screen end points are still needed for clipping) and
+ * is never culled
+ */
+struct sky_index
+{
+    unsigned int num_cells;
+    unsigned int *cell_start; // Cell `c` holds slots [cell_start[c], cell_start[c + 1])
+    double *center_x;         // Unit vector to the center of each cell
+    double *center_y;
+    double *center_z;
+    double *sin_radius; // Sine of the angular radius of each cell's bounding cap
+    bool *visible;      // Whether each cell's stars hold positions in the star table
+};
+
+/* Structure-of-arrays copy of the star table holding what the position kernel
+ * reads each frame. Each star's J2000 position is cached as a rectangular
+ * equatorial unit vector (x, y, z) and its proper motion as the velocity of
+ * that vector in units per Julian year (dx, dy, dz), so propagating a star is
+ * a multiply-add per component. Keeping each field contiguous lets the kernel
+ * stream through the catalog with SIMD loads. Slot `i` holds the star at index
+ * `table_index[i]` of the star table.
+ *
+ * The propagated vectors (eq_x, eq_y, eq_z), renormalized to unit length, are
+ * cached along with the date they were computed for, since between nearby
+ * frames only the Earth's rotation changes and that is handled entirely by the
+ * frame transform
+ */
+struct star_soa
+{
+    unsigned int num_stars;
+    unsigned int *table_index;
+    double *x;
+    double *y;
+    double *z;
+    double *dx;
+    double *dy;
+    double *dz;
+    double *eq_x;
+    double *eq_y;
+    double *eq_z;
+    double eq_julian_date;
+    bool eq_valid;
+};
+
+/* Horizontal coordinates of every positioned object at one instant. Position
+ * updates write here rather than into the object tables, so the positions for
+ * one frame can be computed while another frame is rendered. Star positions
+ * are indexed by star_soa slot and cell visibility by sky_index cell
+ */
+struct frame_positions
 {
-    char *name;
+    double julian_date;
+    double *star_azimuth;
+    double *star_altitude;
+    bool *cell_visible;
+    double planet_azimuth[NUM_PLANETS];
+    double planet_altitude[NUM_PLANETS];
+    double moon_azimuth;
+    double moon_altitude;
 };
 
 // Data structure generation
 
-/* Fill array of star structures using entries from BSC5 and table of star
- * names. Stars with catalog number `n` are mapped to index `n-1`. This function
- * allocates memory which must be freed by the caller. Returns false upon memory
- * allocation error
+// Table generators allocate from an arena, so everything built at startup is
+// freed at once by destroying it
+
+/* Fill a packed table with the stars of a catalog view that are at least as
+ * bright as `threshold`, for catalogs too large to load in full. Only the
+ * magnitude of other records is decoded. Since such catalogs are not numbered
+ * like BSC5, stars are renumbered in catalog order. The table is allocated from
+ * `arena`. Returns false upon memory allocation error
  */
-bool generate_star_table(struct star **star_table, struct entry *entries, struct star_name *name_table, unsigned int num_stars);
+bool generate_bright_packed_star_table(struct packed_star **packed_table, unsigned int *num_stars,
+                                       const struct bsc5_view *catalog, float threshold, struct arena *arena);
 
-/* Parse data from bsc5_names.txt and return an array of names. Stars with
- * catalog number `n` are mapped to index `n-1`. This function allocates memory
- * which should be freed by the caller. Returns false upon memory allocation
- * error.
+/* Fill array of star structures for rendering from a packed table. Stars with
+ * catalog number `n` are mapped to index `n-1`. Star symbols point into a
+ * shared table rather than being copied per star, and stars are unlabeled. The
+ * table is allocated from `arena`. Returns false upon memory allocation error
  */
-bool generate_name_table(const uint8_t *data, size_t data_len, struct star_name **name_table_out, int num_stars);
+bool generate_star_table(struct star **star_table, const struct packed_star *packed_table, unsigned int num_stars,
+                         struct arena *arena);
 
-/* Parse data from bsc5_constellations.txt and return an array of constell
- * structs. This function allocates memory which should  be freed by the
- * caller. Returns false upon memory allocation error.
- *
- * NOTE: bsc5.constellations.txt MUST end in a new line to grab all the data.
+/* Decode the J2000 position (radians) and proper motion (radians per Julian
+ * year) of a packed star
+ */
+void unpack_star(const struct packed_star *packed, double *right_ascension, double *declination, double *ra_motion,
+                 double *dec_motion);
+
+/* Fill a star_soa with the `num_stars` stars whose catalog numbers are listed
+ * in `star_numbers`, in that order, computing each star's unit vector and
+ * proper motion velocity vector from its packed record. Passing the bright end
+ * of the magnitude index (see star_magnitude_cutoff) restricts the store to the
+ * stars that will be displayed. Arrays are allocated from `arena`. Returns
+ * false upon memory allocation error
+ */
+bool generate_star_soa(struct star_soa *star_soa, const struct packed_star *packed_table, const int *star_numbers,
+                       unsigned int num_stars, struct arena *arena);
+
+/* Build a sky index over `star_soa`, reordering its slots by cell. Stars that
+ * appear in any of the `num_const` constellations in `constell_table` are put in
+ * the never culled cell; pass NULL to cull every star. Arrays are allocated
+ * from `arena`. Returns false upon memory allocation error
  */
-bool generate_constell_table(const uint8_t *data, size_t data_len, struct constell **constell_table_out,
-                             unsigned int *num_constell_out);
+bool generate_sky_index(struct sky_index *sky_index, struct star_soa *star_soa, const struct constell *constell_table,
+                        unsigned int num_const, struct arena *arena);
 
-/* Generate an array of planet structs. This function allocates memory which
- * should  be freed by the caller. Returns false upon memory allocation error
+/* Recompute the bounding cap of each cell from the given star positions, one
+ * entry per star_soa slot. Called whenever star positions are re-propagated
+ */
+void sky_index_fit_cells(struct sky_index *sky_index, const double *x, const double *y, const double *z);
+
+/* Allocate a position buffer for `num_stars` star_soa slots and `num_cells`
+ * sky index cells. Unlike startup tables, position buffers belong to whoever
+ * renders or computes frames, so they are allocated on the heap and must be
+ * freed by the caller with free_frame_positions. Returns false upon memory
+ * allocation error
+ */
+bool generate_frame_positions(struct frame_positions *positions, unsigned int num_stars, unsigned int num_cells);
+
+/* Generate an array of planet structs. Symbols and labels are shared static
+ * strings. The table is allocated from `arena`. Returns false upon memory
+ * allocation error
  */
 bool generate_planet_table(struct planet **planet_table, const struct kep_elems *planet_elements,
-                           const struct kep_rates *planet_rates, const struct kep_extra *planet_extras);
+                           const struct kep_rates *planet_rates, const struct kep_extra *planet_extras,
+                           struct arena *arena);
 
 /* Generate a moon struct. Returns false upon error during generation
  */
@@ -115,22 +244,30 @@ bool generate_moon_object(struct moon *moon_data, const struct kep_elems *moon_e
 
 // Memory freeing
 
-void free_stars(struct star *star_table, unsigned int size);
-void free_star_names(struct star_name *name_table, unsigned int size);
-void free_constells(struct constell *constell_table, unsigned int size);
-void free_planets(struct planet *planets, unsigned int size);
+void free_frame_positions(struct frame_positions *positions);
 void free_moon_object(struct moon moon_data);
 
 // Miscellaneous
 
-/* Comparator for star structs
+/* Comparator for star structs, ordering them by decreasing magnitude and then by
+ * catalog number
  */
 int star_magnitude_comparator(const void *v1, const void *v2);
 
 /* Modify an array of star numbers sorted by increasing magnitude. Used in
- * rendering functions so brighter stars are always rendered on top
+ * rendering functions so brighter stars are always rendered on top. The array
+ * is allocated from `arena`
+ */
+bool star_numbers_by_magnitude(int **num_by_mag, struct star *star_table, unsigned int num_stars,
+                               struct arena *arena);
+
+/* Return the position in `num_by_mag` of the first star with a magnitude less
+ * than or equal to `threshold`. Since `num_by_mag` is sorted by decreasing
+ * magnitude, every star from this position onwards is bright enough to be
+ * displayed and every star before it can be skipped without being touched
  */
-bool star_numbers_by_magnitude(int **num_by_mag, struct star *star_table, unsigned int num_stars);
+unsigned int star_magnitude_cutoff(const struct star *star_table, const int *num_by_mag, unsigned int num_stars,
+                                   float threshold);
 
 /* Map a double `input` which lies in range [min_float, max_float]
  * to an integer which lies in range [min_int, max_int].
@@ -4,24 +4,57 @@
 #ifndef CORE_POSITION_H
 #define CORE_POSITION_H
 
+#include "coord.h"
 #include "core.h"
+#include "ephemeris.h"
+#include "thread_pool.h"
 
-/* Update apparent star positions for a given observation time and location by
- * setting the azimuth and altitude of each star struct in an array of star
- * structs
+/* Compute apparent star positions for a given observation time and write the
+ * azimuth and altitude of each star_soa slot to `positions`. Positions are
+ * computed in a single pass over the structure-of-arrays copy of the catalog,
+ * using AVX2 or SSE2 where available. `transform` must have been built for the
+ * same observation time and location.
+ *
+ * Proper motion is only re-applied when the cached equatorial vectors are at
+ * least `pm_interval` days away from `julian_date`; otherwise only the Earth's
+ * rotation, carried by `transform`, is applied.
+ *
+ * If `sky_index` is not NULL, cells of the index lying entirely below the
+ * horizon are skipped and marked as such in `positions`. If `pool` is not NULL
+ * the slots are split between its threads
  */
-void update_star_positions(struct star *star_table, int num_stars, double julian_date, double latitude, double longitude);
+void update_star_positions(struct frame_positions *positions, struct star_soa *star_soa, struct sky_index *sky_index,
+                           struct thread_pool *pool, double julian_date, double pm_interval,
+                           const struct frame_transform *transform);
 
-/* Update apparent Sun & planet positions for a given observation time and
- * location by setting the azimuth and altitude of each planet struct in an
- * array of planet structs
+/* Compute apparent Sun & planet positions for a given observation time and
+ * write them to `positions`. Heliocentric positions are interpolated from
+ * `ephemeris`, which is refitted as needed
  */
-void update_planet_positions(struct planet *planet_table, double julian_date, double latitude, double longitude);
+void update_planet_positions(struct frame_positions *positions, struct planet_ephemeris *ephemeris, double julian_date,
+                             const struct frame_transform *transform);
 
-/* Update apparent Moon positions for a given observation time and
- * location by setting the azimuth and altitude of a moon struct
+/* Compute the apparent Moon position for a given observation time and write
+ * it to `positions`. The Moon's orbital rotation is cached in `rotation`
  */
-void update_moon_position(struct moon *moon_object, double julian_date, double latitude, double longitude);
+void update_moon_position(struct frame_positions *positions, const struct moon *moon_object,
+                          struct orbit_rotation *rotation, double julian_date, const struct frame_transform *transform);
+
+/* Compute the positions of all objects for a given observation time and
+ * location. Only the star_soa, sky index and ephemeris caches are modified, so
+ * this may run on another thread while the object tables are being rendered
+ */
+void update_frame_positions(struct frame_positions *positions, struct star_soa *star_soa, struct sky_index *sky_index,
+                            struct thread_pool *pool, struct planet_ephemeris *ephemeris, const struct moon *moon_object,
+                            double latitude, double longitude, double pm_interval, double julian_date);
+
+/* Copy computed positions into the star, planet and moon tables for
+ * rendering. Stars in sky index cells that have just set are moved to the
+ * nadir so stale positions are not rendered
+ */
+void apply_frame_positions(const struct frame_positions *positions, struct star *star_table,
+                           const struct star_soa *star_soa, struct sky_index *sky_index, struct planet *planet_table,
+                           struct moon *moon_object);
 
 /* Update the phase of the Moon at a given time by setting the unicode symbol
  * for a moon struct
@@ -8,9 +8,12 @@
 
 #include <ncurses.h>
 
-/* Render stars to the screen using a stereographic projection
+/* Render stars to the screen using a stereographic projection. Every one of the
+ * `num_stars` stars listed in `num_by_mag` is drawn, in order, so callers pass
+ * only the part of the magnitude index above the display threshold (see
+ * star_magnitude_cutoff)
  */
-void render_stars_stereo(WINDOW *win, struct conf *config, struct star *star_table, int num_stars, int *num_by_mag);
+void render_stars_stereo(WINDOW *win, struct conf *config, struct star *star_table, int num_stars, const int *num_by_mag);
 
 /* Render the Sun and planets to the screen using a stereographic projection
  */
@@ -34,4 +37,12 @@ void render_azimuthal_grid(WINDOW *win, struct conf *config);
  */
 void render_cardinal_directions(WINDOW *win, struct conf *config);
 
+/* Return the simulated days until any object rendered with a stereographic
+ * projection onto `win` could have moved `cells` cells. Objects move fastest
+ * on screen at the horizon, where the projection maps one radian of sky to the
+ * window's radius, and no object moves across the sky faster than the diurnal
+ * rotation plus the Moon's motion against the stars
+ */
+double render_stereo_days_per_cells(WINDOW *win, double cells);
+
 #endif // CORE_RENDER_H
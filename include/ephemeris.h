@@ -0,0 +1,51 @@
+/* Interpolated planet ephemeris. Rather than solving Kepler's equation for
+ * every planet on every frame, the Keplerian model is evaluated at a handful of
+ * Chebyshev nodes spanning a segment of a few days, and positions within the
+ * segment are served from the resulting Chebyshev series, like the JPL
+ * ephemerides do. Segments are refitted lazily whenever a requested time falls
+ * outside the current one.
+ *
+ * Over a segment the series agrees with the Keplerian model to well below a
+ * kilometer, far more closely than the model agrees with the real planets.
+ */
+
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include "astro.h"
+#include "core.h"
+
+#include <stdbool.h>
+
+// Days spanned by each fitted segment
+#define EPHEMERIS_SEGMENT_DAYS 8.0
+
+// Chebyshev coefficients per coordinate, and Kepler solves per planet per fit
+#define EPHEMERIS_NUM_COEFFS 10
+
+struct planet_ephemeris
+{
+    const struct planet *planet_table;
+    bool valid;
+    double segment_start; // Julian date at which the current segment begins
+    double coeffs[NUM_PLANETS][3][EPHEMERIS_NUM_COEFFS];
+
+    // Orbital rotations kept between fits, and for the Moon, which is still
+    // computed from its model on every frame
+    struct orbit_rotation rotations[NUM_PLANETS];
+    struct orbit_rotation moon_rotation;
+};
+
+/* Create an empty ephemeris for the planets in `planet_table`, which is only
+ * read for orbital elements
+ */
+void planet_ephemeris_init(struct planet_ephemeris *ephemeris, const struct planet *planet_table);
+
+/* Calculate the heliocentric ICRF position of a planet in rectangular
+ * equatorial coordinates, as calc_planet_helio_ICRF does. Refits the ephemeris
+ * if `julian_date` lies outside the current segment
+ */
+void planet_ephemeris_helio_ICRF(struct planet_ephemeris *ephemeris, enum planets planet, double julian_date, double *xh,
+                                 double *yh, double *zh);
+
+#endif // EPHEMERIS_H
@@ -0,0 +1,56 @@
+/* Batched ephemeris for time series. Positions of a set of bodies are computed
+ * for many Julian dates at once and written to contiguous arrays, for building
+ * tables such as rise and set times rather than for drawing frames.
+ *
+ * Dates are handled in blocks, so that Kepler's equation is solved for a whole
+ * block of epochs of a planet at once and orbital rotations are reused across
+ * the block. Blocks are independent and are split between the threads of a
+ * thread pool when one is given.
+ */
+
+#ifndef EPHEMERIS_BATCH_H
+#define EPHEMERIS_BATCH_H
+
+#include "astro.h"
+#include "core.h"
+#include "thread_pool.h"
+
+// Bodies of a batch are the Sun and planets, indexed by enum planets, and the
+// Moon after them
+#define BATCH_MOON NUM_PLANETS
+#define BATCH_NUM_BODIES (NUM_PLANETS + 1)
+
+// Body sets are bit masks of the bodies they contain
+#define BATCH_BODY(body) (1u << (body))
+#define BATCH_ALL_BODIES ((1u << BATCH_NUM_BODIES) - 1u)
+
+/* Output arrays of a batch, in radians. Each holds `count` entries for every
+ * body of the set, body by body in increasing body order, so that the time
+ * series of each body is contiguous. Any array may be NULL if it is not needed
+ *
+ * Right ascension is in [0, 2π) and azimuth is measured East of North in
+ * [0, 2π). Coordinates are geocentric, with no correction for parallax
+ */
+struct batch_positions
+{
+    double *right_ascension;
+    double *declination;
+    double *azimuth;
+    double *altitude;
+};
+
+/* Number of bodies in `body_set`
+ */
+unsigned int batch_num_bodies(unsigned int body_set);
+
+/* Compute the positions of the bodies in `body_set` at `count` Julian dates for
+ * an observer at `latitude` and `longitude`, as update_planet_positions and
+ * update_moon_position do for a single frame. `planet_table` and
+ * `moon_object` are only read for orbital elements. If `pool` is not NULL the
+ * dates are split between its threads
+ */
+void ephemeris_batch_compute(const struct planet *planet_table, const struct moon *moon_object, unsigned int body_set,
+                             const double *julian_dates, unsigned int count, double latitude, double longitude,
+                             struct thread_pool *pool, const struct batch_positions *output);
+
+#endif // EPHEMERIS_BATCH_H
@@ -0,0 +1,62 @@
+/* Event loop for the render loop. A single poll(2) waits on the terminal input,
+ * the frame clock and window resizes at once, so keys and resizes are handled
+ * as soon as they arrive rather than once per frame.
+ *
+ * Frame deadlines are absolute times on the monotonic clock, each one interval
+ * after the previous deadline, so time spent rendering does not accumulate as
+ * drift. On Linux the frame clock is a timerfd and resizes arrive through a
+ * signalfd; elsewhere the poll timeout is computed from the deadline and
+ * SIGWINCH is forwarded through a pipe.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <time.h>
+
+enum event_type
+{
+    EVENT_FRAME,  // The next frame is due
+    EVENT_INPUT,  // Input is ready to be read
+    EVENT_RESIZE, // The terminal was resized
+};
+
+struct event_loop
+{
+    int input_fd;             // -1 once the input has hung up
+    int timer_fd;             // Frame clock, -1 without timerfd
+    int signal_fd;            // Readable after SIGWINCH
+    int signal_write_fd;      // Write end of the SIGWINCH pipe, -1 with signalfd
+    struct timespec start;    // When the loop was initialized, on CLOCK_MONOTONIC
+    struct timespec deadline; // When the next frame is due, on CLOCK_MONOTONIC
+};
+
+/* Start watching `input_fd` and SIGWINCH, with the first frame due right away.
+ * SIGWINCH is blocked for the calling thread, so this must be called before
+ * any other threads are created. Returns false upon error
+ */
+bool event_loop_init(struct event_loop *loop, int input_fd);
+
+/* Make the next frame due `interval` microseconds after the previous one. If
+ * that time has already passed, the missed frames are dropped and the next one
+ * is due right away
+ */
+void event_loop_schedule(struct event_loop *loop, unsigned long interval);
+
+/* Return the seconds from the start of the loop to when the next frame is due,
+ * i.e. the frame about to be drawn after event_loop_wait returned EVENT_FRAME.
+ * Since deadlines are absolute, this never drifts from real time
+ */
+double event_loop_elapsed(const struct event_loop *loop);
+
+/* Wait for the next event. Resizes take precedence over input, which takes
+ * precedence over frames
+ */
+enum event_type event_loop_wait(struct event_loop *loop);
+
+/* Close the loop's file descriptors
+ */
+void event_loop_free(struct event_loop *loop);
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,80 @@
+/* Headless export of computed positions. Positions of stars, the Sun, planets
+ * and the Moon are computed for a range of dates and streamed to a file
+ * descriptor, without any terminal output. Records are formatted into one
+ * large buffer that is sent with write(2) whenever it fills up.
+ *
+ * All angles are in degrees. Right ascension and azimuth lie in [0, 360),
+ * azimuth being measured East of North. Stars below the horizon are exported
+ * too, with a negative altitude.
+ *
+ * CSV output starts with a header line, followed by one line per object per
+ * date:
+ *
+ *     julian_date,object,right_ascension,declination,azimuth,altitude
+ *
+ * where `object` is the catalog number of a star or the name of a Solar System
+ * body.
+ *
+ * Binary output is in native byte order. It starts with the 8 byte magic
+ * EXPORT_BINARY_MAGIC, then for each date holds a 64-bit float Julian date and
+ * a 32-bit unsigned record count, followed by that many 20 byte records of a
+ * 32-bit signed object id and four 32-bit floats (right ascension,
+ * declination, azimuth, altitude). Ids of stars are their catalog numbers;
+ * Solar System bodies have negative ids, -1 - enum planets for the Sun and
+ * planets and EXPORT_MOON_ID for the Moon.
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "core.h"
+#include "thread_pool.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define EXPORT_BINARY_MAGIC "ASTRXPT1"
+#define EXPORT_MOON_ID (-1 - NUM_PLANETS)
+
+enum export_format
+{
+    EXPORT_CSV,
+    EXPORT_BINARY,
+};
+
+struct export_writer
+{
+    int fd;
+    enum export_format format;
+    char *buffer;
+    size_t length;
+    size_t capacity;
+    bool failed; // Whether a write failed, after which output is discarded
+};
+
+/* Create a writer for `fd` and write the header of `format`. Returns false upon
+ * memory allocation error
+ */
+bool export_writer_init(struct export_writer *writer, int fd, enum export_format format);
+
+/* Send everything buffered so far. Returns false if any write has failed
+ */
+bool export_writer_flush(struct export_writer *writer);
+
+/* Free the writer's buffer. Buffered output is not flushed
+ */
+void export_writer_free(struct export_writer *writer);
+
+/* Export the positions of the stars in `star_soa` and of the Sun, planets and
+ * Moon, for an observer at `latitude` and `longitude`, at `num_dates` dates
+ * starting at `start_julian_date` and `step` days apart. Star proper motion is
+ * re-applied every `pm_interval` days, as when rendering. If `pool` is not
+ * NULL, positions are computed on its threads. Returns false upon memory
+ * allocation or write error
+ */
+bool export_positions(struct export_writer *writer, struct star_soa *star_soa, const struct star *star_table,
+                      const struct planet *planet_table, const struct moon *moon_object, struct thread_pool *pool,
+                      double latitude, double longitude, double pm_interval, double start_julian_date, double step,
+                      unsigned long num_dates);
+
+#endif // EXPORT_H
@@ -0,0 +1,35 @@
+/* Adaptive frame pacing for slow terminals. After each frame is presented, the
+ * limiter is told how many bytes were sent and how long sending them took, and
+ * returns how long to wait before starting the next frame.
+ *
+ * With a bandwidth budget, a frame is followed by at least as much time as its
+ * output takes to send at that budget, so the average output rate never
+ * exceeds it however large individual frames are. Independently, when writes
+ * start blocking because the terminal or link cannot keep up, frames are spaced
+ * so that writing takes at most half of each frame, which stops frames from
+ * piling up in the pty.
+ */
+
+#ifndef FRAME_LIMITER_H
+#define FRAME_LIMITER_H
+
+#include <stddef.h>
+
+struct frame_limiter
+{
+    double budget;          // Output bytes per second, 0 for no limit
+    double min_interval;    // Seconds between frames at the requested frame rate
+    double average_latency; // Moving average of seconds spent writing a frame
+};
+
+/* Initialize a limiter for frames at most every `min_interval` seconds and a
+ * budget of `budget` bytes per second, or 0 for no budget
+ */
+void frame_limiter_init(struct frame_limiter *limiter, double budget, double min_interval);
+
+/* Account for a frame that sent `bytes` bytes in `latency` seconds. Returns the
+ * number of seconds from the start of this frame to the start of the next
+ */
+double frame_limiter_update(struct frame_limiter *limiter, size_t bytes, double latency);
+
+#endif // FRAME_LIMITER_H
@@ -0,0 +1,71 @@
+/* Pipelined position updates. A compute thread fills the positions for frame
+ * N + 1 while the render thread draws frame N, so a frame costs the longer of
+ * the two stages rather than their sum.
+ *
+ * Two position buffers are handed back and forth. Each buffer has an atomic
+ * flag saying whether it holds a computed frame that has not been rendered
+ * yet; the compute thread only writes empty buffers and the render thread
+ * only reads full ones, so handing a buffer over is a single release store.
+ * The mutex and condition variable are only used to sleep when one side gets
+ * ahead of the other.
+ */
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "core.h"
+#include "ephemeris.h"
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+struct frame_pipeline
+{
+    struct frame_positions buffers[2];
+    int full[2];               // Accessed atomically
+    int stop;                  // Accessed atomically
+    unsigned int render_index; // Buffer the render thread reads next
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+
+    // Inputs of the compute thread. Only the compute thread touches the
+    // star_soa, sky index and ephemeris caches while the pipeline is running
+    struct star_soa *star_soa;
+    struct sky_index *sky_index;
+    struct thread_pool *pool;
+    struct planet_ephemeris *ephemeris;
+    const struct moon *moon_object;
+    double latitude;
+    double longitude;
+    double pm_interval;
+    double julian_dates[2]; // Time each buffer is computed for, set while it is empty
+};
+
+/* Allocate both position buffers and start the compute thread, which computes
+ * the first two frames at `julian_date` and `julian_date + julian_step`, and
+ * each later one at the time passed to frame_pipeline_release. The moon is
+ * only read for its orbital elements. Returns false upon error
+ */
+bool frame_pipeline_start(struct frame_pipeline *pipeline, struct star_soa *star_soa, struct sky_index *sky_index,
+                          struct thread_pool *pool, struct planet_ephemeris *ephemeris, const struct moon *moon_object,
+                          const struct conf *config, double julian_step);
+
+/* Wait for the next computed frame and return its positions. The buffer stays
+ * owned by the caller until frame_pipeline_release
+ */
+const struct frame_positions *frame_pipeline_acquire(struct frame_pipeline *pipeline);
+
+/* Hand the buffer returned by frame_pipeline_acquire back to the compute
+ * thread, to be filled with the frame at `julian_date`. That frame is rendered
+ * two frames after the one just released, since the other buffer holds the
+ * next
+ */
+void frame_pipeline_release(struct frame_pipeline *pipeline, double julian_date);
+
+/* Stop and join the compute thread and free both buffers
+ */
+void frame_pipeline_stop(struct frame_pipeline *pipeline);
+
+#endif // FRAME_PIPELINE_H
@@ -15,7 +15,7 @@ struct header
     int STAR1;
     int STARN;
     int STNUM;
-    bool MPROP;
+    int MPROP;
     int NMAG;
     int NBENT;
 };
@@ -31,11 +31,45 @@ struct entry
     float XDPM;
 };
 
-/* Parse BSC5 star catalog and fill the array of entry structures (sorted by
- * increasing catalog number, the default order in the BSC5 file). This function
- * allocates memory which must be freed by the caller. Returns false in event
- * of a file error
+/* Read-only view of a catalog in the BSC5 binary format held in memory, either
+ * a byte array or a memory mapped file. Records are decoded in place on
+ * demand, so reading the catalog needs no copy of the data and no array of
+ * entry structures
  */
-bool parse_entries(uint8_t *data, size_t data_size, struct entry **entries_out, unsigned int *num_entries_out);
+struct bsc5_view
+{
+    const uint8_t *records; // First entry record, following the header
+    unsigned int num_entries;
+    void *mapping; // Mapped file, or NULL if the view is over a byte array
+    size_t mapping_size;
+};
+
+/* Point a view at the BSC5 catalog in `data`. Entries are sorted by increasing
+ * catalog number, the default order in the BSC5 file. Returns false if the
+ * header describes a different layout than BSC5's (J2000 coordinates, catalog
+ * numbers, proper motion and one magnitude in 32 byte entries), or if the data
+ * is too short for the header or for the number of entries it declares
+ */
+bool bsc5_view_init(struct bsc5_view *view, const uint8_t *data, size_t data_size);
+
+/* Memory map the catalog file at `path` and point a view at it. Pages are
+ * only read from disk as records are decoded. The view must be released with
+ * bsc5_view_unmap. Returns false if the file cannot be mapped or is not a
+ * valid catalog
+ */
+bool bsc5_view_map(struct bsc5_view *view, const char *path);
+
+/* Unmap a view created with bsc5_view_map
+ */
+void bsc5_view_unmap(struct bsc5_view *view);
+
+/* Decode entry `i` of the view
+ */
+struct entry bsc5_view_entry(const struct bsc5_view *view, unsigned int i);
+
+/* Decode only the magnitude of entry `i` of the view, which is cheaper than
+ * decoding the whole entry when filtering stars
+ */
+float bsc5_view_magnitude(const struct bsc5_view *view, unsigned int i);
 
 #endif // PARSE_BSC5_H
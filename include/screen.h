@@ -0,0 +1,84 @@
+/* Frame diffing between an offscreen canvas and the terminal. Each frame is
+ * drawn into a pad that is never shown, then compared cell by cell against a
+ * copy of the last presented frame, and only cells whose glyph or color changed
+ * are written to the visible window. The visible window is never erased, so
+ * the terminal only receives output for stars and labels that actually moved.
+ *
+ * Changed cells are either copied to a curses window, or, bypassing curses
+ * output entirely, encoded as VT escape sequences into one preallocated buffer
+ * that is sent with a single write(2) per frame.
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <wchar.h>
+
+// Room for a spacing character plus the combining characters curses stores
+// with it (CCHARW_MAX), null terminated
+#define SCREEN_GLYPH_LENGTH 8
+
+// Typical terminal output per changed cell when presenting through curses,
+// which doesn't report what it writes
+#define SCREEN_CURSES_BYTES_PER_CELL 6
+
+struct screen_cell
+{
+    wchar_t glyph[SCREEN_GLYPH_LENGTH];
+    attr_t attrs;
+    short color_pair;
+    bool continuation; // Right half of a double width glyph in the previous cell
+};
+
+struct screen
+{
+    WINDOW *canvas;            // Offscreen pad each frame is drawn into
+    struct screen_cell *cells; // Cells as last presented, row major
+    int height;
+    int width;
+    bool valid; // Whether `cells` matches what is on the terminal
+
+    // VT output, only allocated for screens presented with screen_present_vt
+    bool vt;
+    char *output;
+    size_t output_capacity; // Enough for a frame in which every cell changed
+};
+
+/* Create a canvas of the given size. Pass `vt` to present frames with
+ * screen_present_vt rather than screen_present. Returns false upon memory
+ * allocation error
+ */
+bool screen_init(struct screen *screen, int height, int width, bool vt);
+
+/* Resize the canvas, e.g. after the terminal was resized. The next frame is
+ * presented in full. Returns false upon memory allocation error
+ */
+bool screen_resize(struct screen *screen, int height, int width);
+
+/* Clear the canvas and return it for drawing the next frame
+ */
+WINDOW *screen_begin_frame(struct screen *screen);
+
+/* Copy the cells of the canvas that changed since the last presented frame to
+ * `win`, which must be the size of the canvas. Returns the number of cells
+ * written
+ */
+unsigned int screen_present(struct screen *screen, WINDOW *win);
+
+/* Encode the cells of the canvas that changed since the last presented frame as
+ * VT escape sequences and write them to `fd` with a single write. Cells are
+ * placed where `win` is positioned on the terminal, but `win` itself is not
+ * written to and must not be refreshed. Cursor moves are omitted between
+ * adjacent cells and colors are only set when they change. Returns the number
+ * of bytes written
+ */
+size_t screen_present_vt(struct screen *screen, WINDOW *win, int fd);
+
+/* Free the canvas, cell copy and output buffer
+ */
+void screen_free(struct screen *screen);
+
+#endif // SCREEN_H
@@ -0,0 +1,52 @@
+/* Persistent pool of worker threads for data-parallel loops. Threads are
+ * created once and sleep between jobs, so handing out a job costs a wake-up
+ * rather than a thread creation.
+ *
+ * A job is a range of indices [0, count) which is split into chunks that the
+ * workers, and the calling thread, claim until none are left.
+ * thread_pool_run only returns once every chunk has finished, which acts as a
+ * barrier between a parallel update and whatever reads its results.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+struct thread_pool
+{
+    unsigned int num_threads; // Including the calling thread
+    pthread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+
+    // Current job
+    void (*task)(void *arg, unsigned int begin, unsigned int end);
+    void *arg;
+    unsigned int count;
+    unsigned int chunk_size;
+    unsigned int next;        // First index not yet claimed
+    unsigned int pending;     // Chunks not yet finished
+    unsigned long generation; // Incremented for every job
+    bool shutdown;
+};
+
+/* Start `num_threads` - 1 worker threads; the thread calling thread_pool_run
+ * is the remaining one. Returns false upon error
+ */
+bool thread_pool_init(struct thread_pool *pool, unsigned int num_threads);
+
+/* Run `task` over indices [0, count) and wait for it to complete. The task is
+ * called with disjoint [begin, end) ranges, possibly from several threads at
+ * once. If `pool` is NULL the whole range runs on the calling thread
+ */
+void thread_pool_run(struct thread_pool *pool, void (*task)(void *arg, unsigned int begin, unsigned int end), void *arg,
+                     unsigned int count);
+
+/* Stop and join all worker threads
+ */
+void thread_pool_destroy(struct thread_pool *pool);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,231 @@
+import math
+import struct
+import sys
+
+# Script to precompile the star catalog into C source at build time, so the
+# binary starts with a ready-to-use star table instead of parsing, sorting and
+# allocating one on every launch.
+#
+# python generate_catalog.py bsc5 bsc5_names.txt bsc5_constellations.txt bsc5_catalog.h
+#
+# The output defines:
+#
+# struct star bsc5_catalog_stars[];         // Catalog number n at index n-1
+# const struct packed_star bsc5_catalog_packed[];
+# const int bsc5_catalog_num_by_mag[];      // Catalog numbers, faintest first
+# struct constell bsc5_catalog_constells[];
+# unsigned int bsc5_catalog_num_stars;
+# unsigned int bsc5_catalog_num_constells;
+#
+# Values are computed exactly as generate_bright_packed_star_table,
+# generate_star_table and star_numbers_by_magnitude in src/core.c compute them
+# for catalogs loaded at runtime.
+
+HEADER_BYTES = 28
+ENTRY_BYTES = 32
+
+# Star magnitude mapping, see generate_star_table
+MAG_MAP_UNICODE = ["⬤", "●", "⦁", "•", "•", "∙", "⋅", "⋅", "⋅", "⋅"]
+MAG_MAP_ASCII = ["0", "0", "O", "O", "o", "o", ".", ".", ".", "."]
+
+
+# Round a Python float to the nearest single precision value
+def to_float32(value):
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+# C's round(), which rounds halfway cases away from zero
+def c_round(value):
+    return math.copysign(math.floor(abs(value) + 0.5), value)
+
+
+# See map_float_to_int_range in src/core.c
+def map_float_to_int_range(min_float, max_float, min_int, max_int, value):
+    percent = (value - min_float) / (max_float - min_float)
+    return min_int + int(c_round((max_int - min_int) * percent))
+
+
+# Fixed point scales of packed star fields, see pack_entry in src/core.c
+PACKED_RA_SCALE = 4294967296.0 / (2.0 * math.pi)
+PACKED_DEC_SCALE = 2147483648.0 / math.pi
+PACKED_MOTION_SCALE = 268435456.0
+
+
+def saturate_round(value, min_value, max_value):
+    return int(min(max(c_round(value), min_value), max_value))
+
+
+def pack_star(star):
+    right_ascension = math.fmod(star["right_ascension"], 2.0 * math.pi)
+    if right_ascension < 0.0:
+        right_ascension += 2.0 * math.pi
+    return {
+        "right_ascension": int(c_round(right_ascension * PACKED_RA_SCALE)) % 2**32,
+        "declination": saturate_round(star["declination"] * PACKED_DEC_SCALE, -(2**31), 2**31 - 1),
+        "ra_motion": saturate_round(star["ra_motion"] * PACKED_MOTION_SCALE, -(2**15), 2**15 - 1),
+        "dec_motion": saturate_round(star["dec_motion"] * PACKED_MOTION_SCALE, -(2**15), 2**15 - 1),
+        "magnitude": star["mag"],
+        "symbol": star["symbol_index"],
+    }
+
+
+def c_string(value):
+    if value is None:
+        return "NULL"
+    return '"' + value.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def c_double(value):
+    return repr(float(value))
+
+
+def load_stars(path):
+    with open(path, "rb") as file:
+        data = file.read()
+
+    if len(data) < HEADER_BYTES:
+        raise ValueError(f"{path} is too short for a header")
+
+    # Only the layout of BSC5 itself is read, see bsc5_view_init
+    _, _, starn, stnum, mprop, nmag, nbent = struct.unpack_from("<7i", data, 0)
+    if nbent != ENTRY_BYTES or stnum != 1 or mprop != 1 or nmag != 1:
+        raise ValueError(f"{path} has an unsupported layout (STNUM {stnum}, MPROP {mprop}, NMAG {nmag}, NBENT {nbent})")
+
+    # STARN is negative if coordinates are J2000 (which they are in BSC5) and
+    # positive if they are B1950, which are not supported
+    if starn >= 0:
+        raise ValueError(f"{path} has an unsupported star count {starn}, only J2000 catalogs can be read")
+
+    num_entries = -starn
+    if len(data) < HEADER_BYTES + num_entries * ENTRY_BYTES:
+        raise ValueError(f"{path} is too short for {num_entries} entries")
+
+    min_magnitude = to_float32(-1.46)
+    max_magnitude = to_float32(7.96)
+
+    stars = []
+    for i in range(num_entries):
+        xno, sra0, sdec0, _, mag, xrpm, xdpm = struct.unpack_from("<fdd2shff", data, HEADER_BYTES + i * ENTRY_BYTES)
+        magnitude = to_float32(mag / 100.0)
+        symbol_index = map_float_to_int_range(min_magnitude, max_magnitude, 0, len(MAG_MAP_UNICODE) - 1, magnitude)
+        symbol_index = min(max(symbol_index, 0), len(MAG_MAP_UNICODE) - 1)
+        stars.append(
+            {
+                "catalog_number": int(xno),
+                "right_ascension": sra0,
+                "declination": sdec0,
+                "ra_motion": xrpm,
+                "dec_motion": xdpm,
+                "mag": mag,
+                "magnitude": magnitude,
+                "symbol_index": symbol_index,
+                "label": None,
+            }
+        )
+
+    return stars
+
+
+def load_names(path, stars):
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            line = line.strip()
+            if not line:
+                continue
+            catalog_number, name = line.split(",")[:2]
+            table_index = int(catalog_number) - 1
+            if 0 <= table_index < len(stars):
+                stars[table_index]["label"] = name
+
+
+def load_constellations(path):
+    constells = []
+    with open(path) as file:
+        for line_number, line in enumerate(file):
+            parts = line.split()
+            if not parts:
+                continue
+            num_segments = int(parts[1])
+            star_numbers = [int(x) for x in parts[2:]]
+            if num_segments == 0 or len(star_numbers) < num_segments * 2:
+                raise ValueError(f"Failed to parse line {line_number}")
+            constells.append(star_numbers[: num_segments * 2])
+    return constells
+
+
+def write_catalog(path, stars, constells):
+    # Faintest first, then by catalog number, see star_magnitude_comparator
+    num_by_mag = [
+        star["catalog_number"] for star in sorted(stars, key=lambda star: (-star["magnitude"], star["catalog_number"]))
+    ]
+
+    out = []
+    out.append("// Generated by scripts/generate_catalog.py. Do not edit.")
+    out.append("")
+    out.append('#include "core.h"')
+    out.append("")
+    out.append(f"unsigned int bsc5_catalog_num_stars = {len(stars)};")
+    out.append(f"unsigned int bsc5_catalog_num_constells = {len(constells)};")
+    out.append("")
+
+    out.append(f"struct star bsc5_catalog_stars[{len(stars)}] = {{")
+    for star in stars:
+        symbol_index = star["symbol_index"]
+        out.append(
+            "    {"
+            f".base = {{.symbol_ASCII = '{MAG_MAP_ASCII[symbol_index]}', "
+            f".symbol_unicode = {c_string(MAG_MAP_UNICODE[symbol_index])}, "
+            f".label = {c_string(star['label'])}}}, "
+            f".catalog_number = {star['catalog_number']}, "
+            f".magnitude = {c_double(star['magnitude'])}f"
+            "},"
+        )
+    out.append("};")
+    out.append("")
+
+    out.append(f"const struct packed_star bsc5_catalog_packed[{len(stars)}] = {{")
+    for star in stars:
+        packed = pack_star(star)
+        out.append(
+            "    {"
+            f"{packed['right_ascension']}u, {packed['declination']}, {packed['ra_motion']}, {packed['dec_motion']}, "
+            f"{packed['magnitude']}, {packed['symbol']}"
+            "},"
+        )
+    out.append("};")
+    out.append("")
+
+    out.append(f"const int bsc5_catalog_num_by_mag[{len(stars)}] = {{")
+    for i in range(0, len(num_by_mag), 16):
+        out.append("    " + ", ".join(str(n) for n in num_by_mag[i : i + 16]) + ",")
+    out.append("};")
+    out.append("")
+
+    for i, star_numbers in enumerate(constells):
+        out.append(f"static int bsc5_catalog_constell_{i}[] = {{{', '.join(str(n) for n in star_numbers)}}};")
+    out.append("")
+
+    out.append(f"struct constell bsc5_catalog_constells[{len(constells)}] = {{")
+    for i, star_numbers in enumerate(constells):
+        out.append(f"    {{.num_segments = {len(star_numbers) // 2}, .star_numbers = bsc5_catalog_constell_{i}}},")
+    out.append("};")
+
+    with open(path, "w", encoding="utf-8") as file:
+        file.write("\n".join(out) + "\n")
+
+
+def main():
+    if len(sys.argv) != 5:
+        print(f"Usage: {sys.argv[0]} <bsc5> <names_file> <constellations_file> <output_file>")
+        sys.exit(1)
+
+    bsc5_path, names_path, constellations_path, output_path = sys.argv[1:]
+
+    stars = load_stars(bsc5_path)
+    load_names(names_path, stars)
+    constells = load_constellations(constellations_path)
+    write_catalog(output_path, stars, constells)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,99 @@
+#include "arena.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Alignment of every allocation. Matches what malloc guarantees on common
+// 64-bit platforms
+#define ARENA_ALIGNMENT 16
+
+// Size of the block header, rounded up so block data starts aligned
+#define ARENA_HEADER_SIZE ((sizeof(struct arena_block) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+void arena_init(struct arena *arena, size_t block_size)
+{
+    arena->head = NULL;
+    arena->block_size = block_size;
+    arena->bytes_allocated = 0;
+    arena->bytes_reserved = 0;
+    arena->num_allocations = 0;
+    arena->num_blocks = 0;
+}
+
+/* Allocate a block with room for `size` bytes
+ */
+static struct arena_block *new_block(size_t size)
+{
+    struct arena_block *block = malloc(ARENA_HEADER_SIZE + size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    block->size = size;
+    block->used = 0;
+    block->next = NULL;
+    return block;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    struct arena_block *block = arena->head;
+    if (block == NULL || block->size - block->used < size)
+    {
+        block = new_block(size > arena->block_size ? size : arena->block_size);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        if (size > arena->block_size && arena->head != NULL)
+        {
+            // Oversized requests get a block of their own, placed behind the
+            // head so the rest of the current block is still used
+            block->next = arena->head->next;
+            arena->head->next = block;
+        }
+        else
+        {
+            block->next = arena->head;
+            arena->head = block;
+        }
+
+        arena->bytes_reserved += block->size;
+        arena->num_blocks++;
+    }
+
+    void *memory = (unsigned char *)block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+
+    arena->bytes_allocated += size;
+    arena->num_allocations++;
+
+    return memory;
+}
+
+void arena_print_stats(const struct arena *arena, const char *name)
+{
+    printf("%s: %u allocations, %zu bytes allocated, %zu bytes reserved in %u blocks\n", name,
+           arena->num_allocations, arena->bytes_allocated, arena->bytes_reserved, arena->num_blocks);
+}
+
+void arena_destroy(struct arena *arena)
+{
+    struct arena_block *block = arena->head;
+    while (block != NULL)
+    {
+        struct arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->bytes_allocated = 0;
+    arena->bytes_reserved = 0;
+    arena->num_allocations = 0;
+    arena->num_blocks = 0;
+}
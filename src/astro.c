@@ -4,6 +4,12 @@
 #include <stdio.h>
 #include <time.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -137,21 +143,265 @@ double current_julian_date(void)
     return datetime_to_julian_date(&lt);
 }
 
-static double solve_kepler(double M, double e, double E)
+// Newton steps are clamped to this many radians, which keeps the series for
+// the sine and cosine of a step accurate to about 1e-14
+#define KEPLER_MAX_STEP 0.5
+
+// Radians of eccentric anomaly below which a solution has converged
+#define KEPLER_TOLERANCE 1.0E-12
+
+// Enough for any eccentricity below 1 despite the clamped steps
+#define KEPLER_MAX_ITERATIONS 16
+
+// Epochs handled per pass of the batched planet position kernel
+#define PLANET_BLOCK_SIZE 64
+
+// Radians an orbital angle may drift from where its sine and cosine were last
+// evaluated before they are evaluated again
+#define ROTATION_MAX_DRIFT 0.1
+
+// J2000 obliquity of the ecliptic, 84381.448", folded into orbital rotations
+#define COS_OBLIQUITY 0.9174820620691818
+#define SIN_OBLIQUITY 0.3977771559319137
+
+/* Sine and cosine of a small angle, |step| <= 0.5, by their Taylor series in
+ * Horner form. Accurate to about 1e-14 at the limit and to rounding well below
+ * it. The reciprocals of the term divisors are constants, so each term is a
+ * multiply rather than a division
+ */
+static void small_sin_cos(double step, double *sin_step, double *cos_step)
+{
+    double s2 = step * step;
+
+    double sin_poly = 1.0 - s2 * (1.0 / 110.0);
+    sin_poly = 1.0 - s2 * (1.0 / 72.0) * sin_poly;
+    sin_poly = 1.0 - s2 * (1.0 / 42.0) * sin_poly;
+    sin_poly = 1.0 - s2 * (1.0 / 20.0) * sin_poly;
+    sin_poly = 1.0 - s2 * (1.0 / 6.0) * sin_poly;
+    *sin_step = step * sin_poly;
+
+    double cos_poly = 1.0 - s2 * (1.0 / 132.0);
+    cos_poly = 1.0 - s2 * (1.0 / 90.0) * cos_poly;
+    cos_poly = 1.0 - s2 * (1.0 / 56.0) * cos_poly;
+    cos_poly = 1.0 - s2 * (1.0 / 30.0) * cos_poly;
+    cos_poly = 1.0 - s2 * (1.0 / 12.0) * cos_poly;
+    *cos_step = 1.0 - s2 * (1.0 / 2.0) * cos_poly;
+}
+
+#if defined(__AVX2__)
+/* Four lanes of small_sin_cos
+ */
+static void small_sin_cos_avx2(__m256d step, __m256d *sin_step, __m256d *cos_step)
 {
-    const double to_rad = M_PI / 180.0;
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d s2 = _mm256_mul_pd(step, step);
+
+    __m256d sin_poly = _mm256_sub_pd(one, _mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 110.0)));
+    sin_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 72.0)), sin_poly));
+    sin_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 42.0)), sin_poly));
+    sin_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 20.0)), sin_poly));
+    sin_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 6.0)), sin_poly));
+    *sin_step = _mm256_mul_pd(step, sin_poly);
+
+    __m256d cos_poly = _mm256_sub_pd(one, _mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 132.0)));
+    cos_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 90.0)), cos_poly));
+    cos_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 56.0)), cos_poly));
+    cos_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 30.0)), cos_poly));
+    cos_poly = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 12.0)), cos_poly));
+    *cos_step = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_mul_pd(s2, _mm256_set1_pd(1.0 / 2.0)), cos_poly));
+}
+#elif defined(__SSE2__)
+/* Two lanes of small_sin_cos
+ */
+static void small_sin_cos_sse2(__m128d step, __m128d *sin_step, __m128d *cos_step)
+{
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128d s2 = _mm_mul_pd(step, step);
+
+    __m128d sin_poly = _mm_sub_pd(one, _mm_mul_pd(s2, _mm_set1_pd(1.0 / 110.0)));
+    sin_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 72.0)), sin_poly));
+    sin_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 42.0)), sin_poly));
+    sin_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 20.0)), sin_poly));
+    sin_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 6.0)), sin_poly));
+    *sin_step = _mm_mul_pd(step, sin_poly);
+
+    __m128d cos_poly = _mm_sub_pd(one, _mm_mul_pd(s2, _mm_set1_pd(1.0 / 132.0)));
+    cos_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 90.0)), cos_poly));
+    cos_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 56.0)), cos_poly));
+    cos_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 30.0)), cos_poly));
+    cos_poly = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 12.0)), cos_poly));
+    *cos_step = _mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(s2, _mm_set1_pd(1.0 / 2.0)), cos_poly));
+}
+#endif
+
+void solve_kepler_batch(const double *M, const double *e, unsigned int count, double *E, double *sin_E, double *cos_E)
+{
+    // Newton's method starts from E = M. Its sine and cosine are the only ones
+    // evaluated directly; each step rotates them by the step instead
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        E[i] = M[i];
+        sin_E[i] = sin(M[i]);
+        cos_E[i] = cos(M[i]);
+    }
 
-    double dM = M - (E - e / to_rad * sin(E * to_rad));
-    double dE = dM / (1.0 - e * cos(E * to_rad));
+    unsigned int i = 0;
+
+#if defined(__AVX2__)
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_max_step = _mm256_set1_pd(KEPLER_MAX_STEP);
+    const __m256d v_min_step = _mm256_set1_pd(-KEPLER_MAX_STEP);
+    const __m256d v_tolerance = _mm256_set1_pd(KEPLER_TOLERANCE);
+    const __m256d v_sign = _mm256_set1_pd(-0.0);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256d v_M = _mm256_loadu_pd(&M[i]);
+        const __m256d v_e = _mm256_loadu_pd(&e[i]);
+        __m256d v_E = _mm256_loadu_pd(&E[i]);
+        __m256d v_sin = _mm256_loadu_pd(&sin_E[i]);
+        __m256d v_cos = _mm256_loadu_pd(&cos_E[i]);
+
+        // Lanes keep iterating together; converged ones take zero steps
+        __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        for (int n = 0; n < KEPLER_MAX_ITERATIONS && _mm256_movemask_pd(active) != 0; ++n)
+        {
+            __m256d f = _mm256_sub_pd(_mm256_sub_pd(v_E, _mm256_mul_pd(v_e, v_sin)), v_M);
+            __m256d df = _mm256_sub_pd(v_one, _mm256_mul_pd(v_e, v_cos));
+            __m256d step = _mm256_div_pd(f, df);
+            step = _mm256_max_pd(v_min_step, _mm256_min_pd(v_max_step, step));
+            step = _mm256_and_pd(step, active);
+
+            __m256d sin_step, cos_step;
+            small_sin_cos_avx2(step, &sin_step, &cos_step);
+            __m256d new_sin = _mm256_sub_pd(_mm256_mul_pd(v_sin, cos_step), _mm256_mul_pd(v_cos, sin_step));
+            v_cos = _mm256_add_pd(_mm256_mul_pd(v_cos, cos_step), _mm256_mul_pd(v_sin, sin_step));
+            v_sin = new_sin;
+            v_E = _mm256_sub_pd(v_E, step);
+
+            active = _mm256_cmp_pd(_mm256_andnot_pd(v_sign, step), v_tolerance, _CMP_GE_OQ);
+        }
+
+        _mm256_storeu_pd(&E[i], v_E);
+        _mm256_storeu_pd(&sin_E[i], v_sin);
+        _mm256_storeu_pd(&cos_E[i], v_cos);
+    }
+#elif defined(__SSE2__)
+    const __m128d v_one = _mm_set1_pd(1.0);
+    const __m128d v_max_step = _mm_set1_pd(KEPLER_MAX_STEP);
+    const __m128d v_min_step = _mm_set1_pd(-KEPLER_MAX_STEP);
+    const __m128d v_tolerance = _mm_set1_pd(KEPLER_TOLERANCE);
+    const __m128d v_sign = _mm_set1_pd(-0.0);
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m128d v_M = _mm_loadu_pd(&M[i]);
+        const __m128d v_e = _mm_loadu_pd(&e[i]);
+        __m128d v_E = _mm_loadu_pd(&E[i]);
+        __m128d v_sin = _mm_loadu_pd(&sin_E[i]);
+        __m128d v_cos = _mm_loadu_pd(&cos_E[i]);
+
+        // Lanes keep iterating together; converged ones take zero steps
+        __m128d active = _mm_castsi128_pd(_mm_set1_epi32(-1));
+        for (int n = 0; n < KEPLER_MAX_ITERATIONS && _mm_movemask_pd(active) != 0; ++n)
+        {
+            __m128d f = _mm_sub_pd(_mm_sub_pd(v_E, _mm_mul_pd(v_e, v_sin)), v_M);
+            __m128d df = _mm_sub_pd(v_one, _mm_mul_pd(v_e, v_cos));
+            __m128d step = _mm_div_pd(f, df);
+            step = _mm_max_pd(v_min_step, _mm_min_pd(v_max_step, step));
+            step = _mm_and_pd(step, active);
+
+            __m128d sin_step, cos_step;
+            small_sin_cos_sse2(step, &sin_step, &cos_step);
+            __m128d new_sin = _mm_sub_pd(_mm_mul_pd(v_sin, cos_step), _mm_mul_pd(v_cos, sin_step));
+            v_cos = _mm_add_pd(_mm_mul_pd(v_cos, cos_step), _mm_mul_pd(v_sin, sin_step));
+            v_sin = new_sin;
+            v_E = _mm_sub_pd(v_E, step);
+
+            active = _mm_cmpge_pd(_mm_andnot_pd(v_sign, step), v_tolerance);
+        }
+
+        _mm_storeu_pd(&E[i], v_E);
+        _mm_storeu_pd(&sin_E[i], v_sin);
+        _mm_storeu_pd(&cos_E[i], v_cos);
+    }
+#endif
 
-    return dE;
+    // Scalar fallback and remainder
+    for (; i < count; ++i)
+    {
+        for (int n = 0; n < KEPLER_MAX_ITERATIONS; ++n)
+        {
+            double step = (E[i] - e[i] * sin_E[i] - M[i]) / (1.0 - e[i] * cos_E[i]);
+            step = step > KEPLER_MAX_STEP ? KEPLER_MAX_STEP : step < -KEPLER_MAX_STEP ? -KEPLER_MAX_STEP : step;
+
+            double sin_step, cos_step;
+            small_sin_cos(step, &sin_step, &cos_step);
+            double new_sin = sin_E[i] * cos_step - cos_E[i] * sin_step;
+            cos_E[i] = cos_E[i] * cos_step + sin_E[i] * sin_step;
+            sin_E[i] = new_sin;
+            E[i] -= step;
+
+            if (fabs(step) < KEPLER_TOLERANCE)
+            {
+                break;
+            }
+        }
+    }
 }
 
-/* Calculate the heliocentric ICRF position of a planet in rectangular
- * equatorial coordinates
+/* Rotate the sine and cosine of `base` to those of `base + drift`
  */
-void calc_planet_helio_ICRF(const struct kep_elems *elements, const struct kep_rates *rates, const struct kep_extra *extras,
-                            double julian_date, double *xh, double *yh, double *zh)
+static void rotate_sin_cos(double sin_base, double cos_base, double drift, double *sin_angle, double *cos_angle)
+{
+    double sin_drift, cos_drift;
+    small_sin_cos(drift, &sin_drift, &cos_drift);
+    *sin_angle = sin_base * cos_drift + cos_base * sin_drift;
+    *cos_angle = cos_base * cos_drift - sin_base * sin_drift;
+}
+
+/* Bring `rotation` up to date for the argument of periapsis `w`, longitude of
+ * the ascending node `O` and inclination `I`, in radians
+ */
+static void orbit_rotation_update(struct orbit_rotation *rotation, double w, double O, double I)
+{
+    if (!rotation->valid || fabs(w - rotation->w) > ROTATION_MAX_DRIFT || fabs(O - rotation->O) > ROTATION_MAX_DRIFT ||
+        fabs(I - rotation->I) > ROTATION_MAX_DRIFT)
+    {
+        rotation->w = w;
+        rotation->O = O;
+        rotation->I = I;
+        rotation->sin_w = sin(w);
+        rotation->cos_w = cos(w);
+        rotation->sin_O = sin(O);
+        rotation->cos_O = cos(O);
+        rotation->sin_I = sin(I);
+        rotation->cos_I = cos(I);
+        rotation->valid = true;
+    }
+
+    double sin_w, cos_w, sin_O, cos_O, sin_I, cos_I;
+    rotate_sin_cos(rotation->sin_w, rotation->cos_w, w - rotation->w, &sin_w, &cos_w);
+    rotate_sin_cos(rotation->sin_O, rotation->cos_O, O - rotation->O, &sin_O, &cos_O);
+    rotate_sin_cos(rotation->sin_I, rotation->cos_I, I - rotation->I, &sin_I, &cos_I);
+
+    // Orbital plane to ecliptic
+    double x_ecl[2] = {cos_w * cos_O - sin_w * sin_O * cos_I, -sin_w * cos_O - cos_w * sin_O * cos_I};
+    double y_ecl[2] = {cos_w * sin_O + sin_w * cos_O * cos_I, -sin_w * sin_O + cos_w * cos_O * cos_I};
+    double z_ecl[2] = {sin_w * sin_I, cos_w * sin_I};
+
+    // Ecliptic to equatorial
+    for (int column = 0; column < 2; ++column)
+    {
+        rotation->matrix[0][column] = x_ecl[column];
+        rotation->matrix[1][column] = COS_OBLIQUITY * y_ecl[column] - SIN_OBLIQUITY * z_ecl[column];
+        rotation->matrix[2][column] = SIN_OBLIQUITY * y_ecl[column] + COS_OBLIQUITY * z_ecl[column];
+    }
+}
+
+/* Calculate the Keplerian elements of a planet at a given time, with angles in
+ * degrees
+ */
+static void planet_orbit(const struct kep_elems *elements, const struct kep_rates *rates, const struct kep_extra *extras,
+                         double julian_date, struct kep_elems *orbit)
 {
     // Explanatory Supplement to the Astronomical Almanac: Chapter 8,  Page 340
 
@@ -162,15 +412,15 @@ void calc_planet_helio_ICRF(const struct kep_elems *elements, const struct kep_r
     // Calculate number of centuries past J2000
     double t = (julian_date - 2451545.0) / 36525.0;
 
-    double a = elements->a + rates->da * t;
-    double e = elements->e + rates->de * t;
-    double I = elements->I + rates->dI * t;
-    double M = elements->M + rates->dM * t;
-    double w = elements->w + rates->dw * t;
-    double O = elements->O + rates->dO * t;
+    orbit->a = elements->a + rates->da * t;
+    orbit->e = elements->e + rates->de * t;
+    orbit->I = elements->I + rates->dI * t;
+    orbit->M = elements->M + rates->dM * t;
+    orbit->w = elements->w + rates->dw * t;
+    orbit->O = elements->O + rates->dO * t;
 
-    double L = M + w + O; // Mean longitude
-    double w_bar = w + O; // Longitude of perihelion
+    double L = orbit->M + orbit->w + orbit->O; // Mean longitude
+    double w_bar = orbit->w + orbit->O;        // Longitude of perihelion
 
     // 2.
     if (extras != NULL)
@@ -179,56 +429,76 @@ void calc_planet_helio_ICRF(const struct kep_elems *elements, const struct kep_r
         double c = extras->c;
         double s = extras->s;
         double f = extras->f;
-        M = L - w_bar + b * t * t + c * cos(f * t * to_rad) + s * sin(f * t * to_rad);
+        orbit->M = L - w_bar + b * t * t + c * cos(f * t * to_rad) + s * sin(f * t * to_rad);
     }
 
     // 3.
 
-    while (M > 180.0)
+    while (orbit->M > 180.0)
     {
-        M -= 360.0;
+        orbit->M -= 360.0;
     }
+}
 
-    double e_star = 180.0 / M_PI * e;
-    double E = M + e_star * sin(M * to_rad);
+void calc_planet_helio_ICRF_epochs(const struct kep_elems *elements, const struct kep_rates *rates,
+                                   const struct kep_extra *extras, const double *julian_dates, unsigned int count,
+                                   struct orbit_rotation *rotation, double *xh, double *yh, double *zh)
+{
+    const double to_rad = M_PI / 180.0;
 
-    double dE = 1.0;
-    int n = 0;
-    while (fabs(dE) > 1E-6 && n < 10)
+    struct orbit_rotation local_rotation = {.valid = false};
+    if (rotation == NULL)
     {
-        dE = solve_kepler(M, e, E);
-        E += dE;
-        n++;
+        rotation = &local_rotation;
     }
 
-    // 4.
+    for (unsigned int begin = 0; begin < count; begin += PLANET_BLOCK_SIZE)
+    {
+        unsigned int block_count = count - begin < PLANET_BLOCK_SIZE ? count - begin : PLANET_BLOCK_SIZE;
 
-    const double xp = a * (cos(E * to_rad) - e);
-    const double yp = a * sqrt(1.0 - e * e) * sin(E * to_rad);
-    const double zp = 0.0;
+        struct kep_elems orbits[PLANET_BLOCK_SIZE];
+        double M[PLANET_BLOCK_SIZE], e[PLANET_BLOCK_SIZE];
+        for (unsigned int j = 0; j < block_count; ++j)
+        {
+            planet_orbit(elements, rates, extras, julian_dates[begin + j], &orbits[j]);
+            M[j] = orbits[j].M * to_rad;
+            e[j] = orbits[j].e;
+        }
 
-    // 5.
+        // 3. Solve Kepler's equation for the whole block at once
 
-    a *= to_rad;
-    e *= to_rad;
-    I *= to_rad;
-    L *= to_rad;
-    w *= to_rad;
-    O *= to_rad;
-    double xecl = (cos(w) * cos(O) - sin(w) * sin(O) * cos(I)) * xp + (-sin(w) * cos(O) - cos(w) * sin(O) * cos(I)) * yp;
-    double yecl = (cos(w) * sin(O) + sin(w) * cos(O) * cos(I)) * xp + (-sin(w) * sin(O) + cos(w) * cos(O) * cos(I)) * yp;
-    double zecl = (sin(w) * sin(I)) * xp + (cos(w) * sin(I)) * yp;
+        double E[PLANET_BLOCK_SIZE], sin_E[PLANET_BLOCK_SIZE], cos_E[PLANET_BLOCK_SIZE];
+        solve_kepler_batch(M, e, block_count, E, sin_E, cos_E);
 
-    // 6.
+        for (unsigned int j = 0; j < block_count; ++j)
+        {
+            double a = orbits[j].a;
+            double ecc = orbits[j].e;
 
-    // Obliquity at J2000 in radians
-    double eps = 84381.448 / (60.0 * 60.0) * to_rad;
+            // 4.
 
-    *xh = xecl;
-    *yh = cos(eps) * yecl - sin(eps) * zecl;
-    *zh = sin(eps) * yecl + cos(eps) * zecl;
+            const double xp = a * (cos_E[j] - ecc);
+            const double yp = a * sqrt(1.0 - ecc * ecc) * sin_E[j];
 
-    return;
+            // 5. & 6. Rotate to the ecliptic and on to the equator
+
+            orbit_rotation_update(rotation, orbits[j].w * to_rad, orbits[j].O * to_rad, orbits[j].I * to_rad);
+            double(*m)[2] = rotation->matrix;
+
+            xh[begin + j] = m[0][0] * xp + m[0][1] * yp;
+            yh[begin + j] = m[1][0] * xp + m[1][1] * yp;
+            zh[begin + j] = m[2][0] * xp + m[2][1] * yp;
+        }
+    }
+}
+
+/* Calculate the heliocentric ICRF position of a planet in rectangular
+ * equatorial coordinates
+ */
+void calc_planet_helio_ICRF(const struct kep_elems *elements, const struct kep_rates *rates, const struct kep_extra *extras,
+                            double julian_date, double *xh, double *yh, double *zh)
+{
+    calc_planet_helio_ICRF_epochs(elements, rates, extras, &julian_date, 1, NULL, xh, yh, zh);
 }
 
 /* Correct ICRF for polar motion, precession, nutation, frame bias & earth
@@ -263,7 +533,7 @@ void calc_planet_geo_ICRF(double xe, double ye, double ze, const struct kep_elem
 }
 
 void calc_moon_geo_ICRF(const struct kep_elems *moon_elements, const struct kep_rates *moon_rates, double julian_date,
-                        double *xg, double *yg, double *zg)
+                        struct orbit_rotation *rotation, double *xg, double *yg, double *zg)
 {
     // Algorithm taken from Paul Schlyter's page "How to compute planetary
     // positions" https://stjarnhimlen.se/comp/ppcomp.html#6 (modified)
@@ -293,39 +563,27 @@ void calc_moon_geo_ICRF(const struct kep_elems *moon_elements, const struct kep_
     }
 
     // Compute the eccentric anomaly, E
-    double e_star = 180.0 / M_PI * e;
-    double E = M + e_star * sin(M * to_rad) * (1.0 + e * cos(M * to_rad));
+    double M_rad = M * to_rad;
+    double E, sin_E, cos_E;
+    solve_kepler_batch(&M_rad, &e, 1, &E, &sin_E, &cos_E);
+
+    // Compute moon's geocentric  coordinates in its orbital plane
+    double xp = a * (cos_E - e);
+    double yp = a * sqrt(1.0 - e * e) * sin_E;
 
-    double dE = 1.0;
-    int n = 0;
-    while (fabs(dE) > 1E-6 && n < 10)
+    // Compute the moon's position in 3-dimensional space in ecliptic coords,
+    // then convert to equatorial coords
+    struct orbit_rotation local_rotation = {.valid = false};
+    if (rotation == NULL)
     {
-        dE = solve_kepler(M, e, E);
-        E += dE;
-        n++;
+        rotation = &local_rotation;
     }
+    orbit_rotation_update(rotation, w * to_rad, O * to_rad, I * to_rad);
+    double(*m)[2] = rotation->matrix;
 
-    // Compute moon's geocentric  coordinates in its orbital plane
-    double xp = a * (cos(E * to_rad) - e);
-    double yp = a * sqrt(1.0 - e * e) * sin(E * to_rad);
-    double zp = 0.0;
-
-    // Compute the moon's position in 3-dimensional space in ecliptic coords
-    I *= to_rad;
-    w *= to_rad;
-    O *= to_rad;
-    M *= to_rad;
-    double xecl = (cos(w) * cos(O) - sin(w) * sin(O) * cos(I)) * xp + (-sin(w) * cos(O) - cos(w) * sin(O) * cos(I)) * yp;
-    double yecl = (cos(w) * sin(O) + sin(w) * cos(O) * cos(I)) * xp + (-sin(w) * sin(O) + cos(w) * cos(O) * cos(I)) * yp;
-    double zecl = (sin(w) * sin(I)) * xp + (cos(w) * sin(I)) * yp;
-
-    // Obliquity at J2000 in radians
-    double eps = 84381.448 / (60.0 * 60.0) * to_rad;
-
-    // Convert to equatorial coords
-    *xg = xecl;
-    *yg = cos(eps) * yecl - sin(eps) * zecl;
-    *zg = sin(eps) * yecl + cos(eps) * zecl;
+    *xg = m[0][0] * xp + m[0][1] * yp;
+    *yg = m[1][0] * xp + m[1][1] * yp;
+    *zg = m[2][0] * xp + m[2][1] * yp;
 
     return;
 }
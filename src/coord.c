@@ -2,10 +2,183 @@
 
 #include <math.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// Frame transform
+
+void frame_transform_init(struct frame_transform *transform, double gmst, double latitude, double longitude)
+{
+    // Rotate by the local sidereal time about the pole so the x-axis lies on
+    // the observer's meridian, then tilt by the latitude. Rows are the North,
+    // East and zenith unit vectors in equatorial coordinates
+    double local_sidereal_time = gmst + longitude;
+
+    double sin_lst = sin(local_sidereal_time);
+    double cos_lst = cos(local_sidereal_time);
+    double sin_lat = sin(latitude);
+    double cos_lat = cos(latitude);
+
+    double(*m)[3] = transform->matrix;
+
+    m[0][0] = -sin_lat * cos_lst;
+    m[0][1] = -sin_lat * sin_lst;
+    m[0][2] = cos_lat;
+
+    m[1][0] = -sin_lst;
+    m[1][1] = cos_lst;
+    m[1][2] = 0.0;
+
+    m[2][0] = cos_lat * cos_lst;
+    m[2][1] = cos_lat * sin_lst;
+    m[2][2] = sin_lat;
+}
+
+/* Azimuth from the North and East components of a horizontal vector, measured
+ * East of North in [0, 2π)
+ */
+static double horizontal_azimuth(double north, double east)
+{
+    double azimuth = atan2(east, north);
+    if (azimuth < 0.0)
+    {
+        azimuth += 2.0 * M_PI;
+    }
+    return azimuth;
+}
+
+void frame_transform_apply(const struct frame_transform *transform, double xeq, double yeq, double zeq, double *azimuth,
+                           double *altitude)
+{
+    const double(*m)[3] = transform->matrix;
+
+    double north = m[0][0] * xeq + m[0][1] * yeq + m[0][2] * zeq;
+    double east = m[1][0] * xeq + m[1][1] * yeq + m[1][2] * zeq;
+    double zenith = m[2][0] * xeq + m[2][1] * yeq + m[2][2] * zeq;
+
+    *azimuth = horizontal_azimuth(north, east);
+    *altitude = atan2(zenith, sqrt(north * north + east * east));
+}
+
+// Number of vectors rotated per pass. Intermediate components for a block live
+// in stack buffers small enough to stay in L1
+#define TRANSFORM_BLOCK_SIZE 256
+
+/* Rotate `count` <= TRANSFORM_BLOCK_SIZE vectors into North, East and zenith
+ * components
+ */
+static void frame_transform_rotate_block(const struct frame_transform *transform, const double *x, const double *y,
+                                         const double *z, unsigned int count, double *north, double *east,
+                                         double *zenith)
+{
+    const double(*m)[3] = transform->matrix;
+
+    unsigned int i = 0;
+
+#if defined(__AVX2__)
+    __m256d v_m[3][3];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            v_m[r][c] = _mm256_set1_pd(m[r][c]);
+        }
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d v_x = _mm256_loadu_pd(&x[i]);
+        __m256d v_y = _mm256_loadu_pd(&y[i]);
+        __m256d v_z = _mm256_loadu_pd(&z[i]);
+
+        __m256d v_n = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(v_m[0][0], v_x), _mm256_mul_pd(v_m[0][1], v_y)),
+                                    _mm256_mul_pd(v_m[0][2], v_z));
+        __m256d v_e = _mm256_add_pd(_mm256_mul_pd(v_m[1][0], v_x), _mm256_mul_pd(v_m[1][1], v_y));
+        __m256d v_u = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(v_m[2][0], v_x), _mm256_mul_pd(v_m[2][1], v_y)),
+                                    _mm256_mul_pd(v_m[2][2], v_z));
+
+        _mm256_storeu_pd(&north[i], v_n);
+        _mm256_storeu_pd(&east[i], v_e);
+        _mm256_storeu_pd(&zenith[i], v_u);
+    }
+#elif defined(__SSE2__)
+    __m128d v_m[3][3];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            v_m[r][c] = _mm_set1_pd(m[r][c]);
+        }
+    }
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d v_x = _mm_loadu_pd(&x[i]);
+        __m128d v_y = _mm_loadu_pd(&y[i]);
+        __m128d v_z = _mm_loadu_pd(&z[i]);
+
+        __m128d v_n =
+            _mm_add_pd(_mm_add_pd(_mm_mul_pd(v_m[0][0], v_x), _mm_mul_pd(v_m[0][1], v_y)), _mm_mul_pd(v_m[0][2], v_z));
+        __m128d v_e = _mm_add_pd(_mm_mul_pd(v_m[1][0], v_x), _mm_mul_pd(v_m[1][1], v_y));
+        __m128d v_u =
+            _mm_add_pd(_mm_add_pd(_mm_mul_pd(v_m[2][0], v_x), _mm_mul_pd(v_m[2][1], v_y)), _mm_mul_pd(v_m[2][2], v_z));
+
+        _mm_storeu_pd(&north[i], v_n);
+        _mm_storeu_pd(&east[i], v_e);
+        _mm_storeu_pd(&zenith[i], v_u);
+    }
+#endif
+
+    // Scalar fallback and remainder
+    for (; i < count; ++i)
+    {
+        north[i] = m[0][0] * x[i] + m[0][1] * y[i] + m[0][2] * z[i];
+        east[i] = m[1][0] * x[i] + m[1][1] * y[i];
+        zenith[i] = m[2][0] * x[i] + m[2][1] * y[i] + m[2][2] * z[i];
+    }
+}
+
+void frame_transform_unit_vectors(const struct frame_transform *transform, const double *x, const double *y,
+                                  const double *z, unsigned int count, double *azimuth, double *altitude)
+{
+    double north[TRANSFORM_BLOCK_SIZE];
+    double east[TRANSFORM_BLOCK_SIZE];
+    double zenith[TRANSFORM_BLOCK_SIZE];
+
+    for (unsigned int begin = 0; begin < count; begin += TRANSFORM_BLOCK_SIZE)
+    {
+        unsigned int block = count - begin;
+        if (block > TRANSFORM_BLOCK_SIZE)
+        {
+            block = TRANSFORM_BLOCK_SIZE;
+        }
+
+        frame_transform_rotate_block(transform, &x[begin], &y[begin], &z[begin], block, north, east, zenith);
+
+        for (unsigned int i = 0; i < block; ++i)
+        {
+            // Guard against rounding pushing |zenith| slightly past 1
+            double sin_alt = zenith[i];
+            if (sin_alt > 1.0)
+            {
+                sin_alt = 1.0;
+            }
+            else if (sin_alt < -1.0)
+            {
+                sin_alt = -1.0;
+            }
+
+            altitude[begin + i] = asin(sin_alt);
+            azimuth[begin + i] = horizontal_azimuth(north[i], east[i]);
+        }
+    }
+}
+
 // Conversions
 
 void equatorial_rectangular_to_spherical(double xeq, double yeq, double zeq, double *right_ascension, double *declination)
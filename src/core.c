@@ -1,5 +1,6 @@
 #include "core.h"
 
+#include "arena.h"
 #include "astro.h"
 #include "parse_BSC5.h"
 
@@ -9,480 +10,536 @@
 #include <string.h>
 #include <time.h>
 
-/* Count number of lines in file
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Data generation
+
+// Star magnitude mapping, shared by all stars
+// FIXME: some of these characters render on WSL while not on macOS
+// (system wide, not just this project). I haven't gotten to the bottom
+// of this yet...
+// TODO: add CLI option to choose between these
+#define NUM_STAR_SYMBOLS 10
+static const char *star_symbols_unicode[NUM_STAR_SYMBOLS] = {"⬤", "●", "⦁", "•", "•", "∙", "⋅", "⋅", "⋅", "⋅"};
+// const char *mag_map_unicode_diamond[10] = {"⯁", "◇", "⬥", "⬦", "⬩",
+// "🞘", "🞗", "🞗", "🞗", "🞗"}; const char *mag_map_unicode_open[10]    =
+// {"✩", "✧", "⋄", "⭒", "🞝", "🞝", "🞝", "🞝", "🞝", "🞝"}; const char
+// *mag_map_unicode_filled[10]  = {"★", "✦", "⬩", "⭑", "🞝", "🞝", "🞝",
+// "🞝", "🞝", "🞝"};
+static const char star_symbols_ASCII[NUM_STAR_SYMBOLS] = {'0', '0', 'O', 'O', 'o', 'o', '.', '.', '.', '.'};
+
+// Fixed point scales of packed star fields
+static const double packed_ra_scale = 4294967296.0 / (2.0 * M_PI); // 2^32 per turn
+static const double packed_dec_scale = 2147483648.0 / M_PI;        // 2^31 per half turn
+static const double packed_motion_scale = 268435456.0;             // 2^28 per radian
+
+/* Round to the nearest integer, saturating to [min, max]
  */
-unsigned int count_lines_from_data(const uint8_t *data, size_t data_len)
+static long saturate_round(double value, long min, long max)
 {
-    unsigned int count = 0;
-    for (size_t i = 0; i < data_len; ++i)
+    double rounded = round(value);
+    if (rounded < (double)min)
     {
-        if (data[i] == '\n')
-        {
-            ++count;
-        }
+        return min;
     }
-    return count;
+    if (rounded > (double)max)
+    {
+        return max;
+    }
+    return (long)rounded;
 }
 
-// Data generation
-
-bool generate_star_table(struct star **star_table_out, struct entry *entries, struct star_name *name_table,
-                         unsigned int num_stars)
+static struct packed_star pack_entry(struct entry entry)
 {
-    *star_table_out = malloc(num_stars * sizeof(struct star));
-    if (*star_table_out == NULL)
+    struct packed_star packed;
+
+    // Right ascension wraps around, so a full turn is stored as 0
+    double right_ascension = fmod(entry.SRA0, 2.0 * M_PI);
+    if (right_ascension < 0.0)
     {
-        printf("Allocation of memory for star table failed\n");
-        return false;
+        right_ascension += 2.0 * M_PI;
     }
+    packed.right_ascension = (uint32_t)(unsigned long long)llround(right_ascension * packed_ra_scale);
+    packed.declination = (int32_t)saturate_round(entry.SDEC0 * packed_dec_scale, INT32_MIN, INT32_MAX);
+    packed.ra_motion = (int16_t)saturate_round(entry.XRPM * packed_motion_scale, INT16_MIN, INT16_MAX);
+    packed.dec_motion = (int16_t)saturate_round(entry.XDPM * packed_motion_scale, INT16_MIN, INT16_MAX);
+    packed.magnitude = (int16_t)entry.MAG;
 
-    for (unsigned int i = 0; i < num_stars; ++i)
-    {
-        struct star temp_star;
+    const float min_magnitude = -1.46f;
+    const float max_magnitude = 7.96f;
 
-        temp_star.catalog_number = (int)entries[i].XNO;
-        temp_star.right_ascension = entries[i].SRA0;
-        temp_star.declination = entries[i].SDEC0;
-        temp_star.ra_motion = (double)entries[i].XRPM;
-        temp_star.ra_motion = (double)entries[i].XDPM;
-        temp_star.magnitude = entries[i].MAG / 100.0f;
-
-        // Star magnitude mapping
-        // FIXME: some of these characters render on WSL while not on macOS
-        // (system wide, not just this project). I haven't gotten to the bottom
-        // of this yet...
-        // TODO: add CLI option to choose between these
-        const char *mag_map_unicode_round[10] = {"⬤", "●", "⦁", "•", "•", "∙", "⋅", "⋅", "⋅", "⋅"};
-        // const char *mag_map_unicode_diamond[10] = {"⯁", "◇", "⬥", "⬦", "⬩",
-        // "🞘", "🞗", "🞗", "🞗", "🞗"}; const char *mag_map_unicode_open[10]    =
-        // {"✩", "✧", "⋄", "⭒", "🞝", "🞝", "🞝", "🞝", "🞝", "🞝"}; const char
-        // *mag_map_unicode_filled[10]  = {"★", "✦", "⬩", "⭑", "🞝", "🞝", "🞝",
-        // "🞝", "🞝", "🞝"};
-        const char mag_map_round_ASCII[10] = {'0', '0', 'O', 'O', 'o', 'o', '.', '.', '.', '.'};
-
-        const float min_magnitude = -1.46f;
-        const float max_magnitude = 7.96f;
-
-        int symbol_index = map_float_to_int_range(min_magnitude, max_magnitude, 0, 9, temp_star.magnitude);
+    // Catalogs loaded with --catalog can go well beyond the magnitudes of BSC5,
+    // so the symbol index is clamped to the symbol table
+    int symbol =
+        map_float_to_int_range(min_magnitude, max_magnitude, 0, NUM_STAR_SYMBOLS - 1, packed.magnitude / 100.0f);
+    if (symbol < 0)
+    {
+        symbol = 0;
+    }
+    else if (symbol > NUM_STAR_SYMBOLS - 1)
+    {
+        symbol = NUM_STAR_SYMBOLS - 1;
+    }
+    packed.symbol = (uint16_t)symbol;
 
-        temp_star.base = (struct object_base){
-            .color_pair = 0,
-            .symbol_ASCII = (char)mag_map_round_ASCII[symbol_index],
-        };
+    return packed;
+}
 
-        // Allocate memory for unicode symbol
-        const char *unicode_temp = mag_map_unicode_round[symbol_index];
+void unpack_star(const struct packed_star *packed, double *right_ascension, double *declination, double *ra_motion,
+                 double *dec_motion)
+{
+    *right_ascension = packed->right_ascension / packed_ra_scale;
+    *declination = packed->declination / packed_dec_scale;
+    *ra_motion = packed->ra_motion / packed_motion_scale;
+    *dec_motion = packed->dec_motion / packed_motion_scale;
+}
 
-        temp_star.base.symbol_unicode = malloc(strlen(unicode_temp) + 1);
-        if (temp_star.base.symbol_unicode == NULL)
+bool generate_bright_packed_star_table(struct packed_star **packed_table_out, unsigned int *num_stars_out,
+                                       const struct bsc5_view *catalog, float threshold, struct arena *arena)
+{
+    // Count the bright stars first so the table is allocated once at its final
+    // size instead of being grown, which an arena cannot do in place. Only the
+    // magnitude is read for stars that are filtered out
+    unsigned int num_stars = 0;
+    for (unsigned int i = 0; i < catalog->num_entries; ++i)
+    {
+        if (bsc5_view_magnitude(catalog, i) <= threshold)
         {
-            printf("Allocation of memory for star struct symbol failed\n");
-            return false;
+            ++num_stars;
         }
-        strcpy(temp_star.base.symbol_unicode, unicode_temp);
+    }
 
-        // Allocate memory for label
-        if (name_table[i].name != NULL)
-        {
-            char *label_temp = name_table[i].name;
+    *packed_table_out = arena_alloc(arena, num_stars * sizeof(struct packed_star));
+    if (*packed_table_out == NULL)
+    {
+        printf("Allocation of memory for packed star table failed\n");
+        return false;
+    }
 
-            temp_star.base.label = malloc(strlen(label_temp) + 1);
-            if (temp_star.base.label == NULL)
-            {
-                printf("Allocation of memory for star struct label failed\n");
-                return false;
-            }
-            strcpy(temp_star.base.label, label_temp);
+    unsigned int table_index = 0;
+    for (unsigned int i = 0; i < catalog->num_entries && table_index < num_stars; ++i)
+    {
+        if (bsc5_view_magnitude(catalog, i) > threshold)
+        {
+            continue;
         }
 
-        // Copy temp struct to table index
-        (*star_table_out)[i] = temp_star;
+        (*packed_table_out)[table_index] = pack_entry(bsc5_view_entry(catalog, i));
+        ++table_index;
     }
 
+    *num_stars_out = num_stars;
+
     return true;
 }
 
-bool generate_planet_table(struct planet **planet_table, const struct kep_elems *planet_elements,
-                           const struct kep_rates *planet_rates, const struct kep_extra *planet_extras)
+bool generate_star_table(struct star **star_table_out, const struct packed_star *packed_table, unsigned int num_stars,
+                         struct arena *arena)
 {
-    *planet_table = malloc(NUM_PLANETS * sizeof(struct planet));
-    if (*planet_table == NULL)
+    *star_table_out = arena_alloc(arena, num_stars * sizeof(struct star));
+    if (*star_table_out == NULL)
     {
+        printf("Allocation of memory for star table failed\n");
         return false;
     }
 
-    const char *planet_symbols_unicode[NUM_PLANETS] = {
-        [SUN] = "☉",     [MERCURY] = "☿", [VENUS] = "♀",  [EARTH] = "🜨",  [MARS] = "♂",
-        [JUPITER] = "♃", [SATURN] = "♄",  [URANUS] = "⛢", [NEPTUNE] = "♆"};
+    for (unsigned int i = 0; i < num_stars; ++i)
+    {
+        const struct packed_star *packed = &packed_table[i];
+        struct star temp_star;
 
-    const char planet_symbols_ASCII[NUM_PLANETS] = {
-        [SUN] = '@',     [MERCURY] = '*', [VENUS] = '*',  [EARTH] = '*',  [MARS] = '*',
-        [JUPITER] = '*', [SATURN] = '*',  [URANUS] = '*', [NEPTUNE] = '*'};
+        temp_star.catalog_number = (int)i + 1;
+        temp_star.magnitude = packed->magnitude / 100.0f;
 
-    const char *planet_labels[NUM_PLANETS] = {
-        [SUN] = "Sun",         [MERCURY] = "Mercury", [VENUS] = "Venus",   [EARTH] = "Earth",    [MARS] = "Mars",
-        [JUPITER] = "Jupiter", [SATURN] = "Saturn",   [URANUS] = "Uranus", [NEPTUNE] = "Neptune"};
+        temp_star.base = (struct object_base){
+            .color_pair = 0,
+            .symbol_ASCII = star_symbols_ASCII[packed->symbol],
+            .symbol_unicode = star_symbols_unicode[packed->symbol],
+            .label = NULL,
+        };
 
-    // TODO: find better way to map these values
-    const int planet_colors[NUM_PLANETS] = {
-        [SUN] = 4, [MERCURY] = 8, [VENUS] = 4, [MARS] = 2, [JUPITER] = 6, [SATURN] = 4, [URANUS] = 7, [NEPTUNE] = 5,
-    };
+        // Copy temp struct to table index
+        (*star_table_out)[i] = temp_star;
+    }
 
-    // TODO: compute these values...?
-    const float planet_mean_mags[NUM_PLANETS] = {
-        [SUN] = -26.832f,   [MERCURY] = 0.23f, [VENUS] = -4.14f, [MARS] = 0.71f,
-        [JUPITER] = -2.20f, [SATURN] = 0.46f,  [URANUS] = 5.68f, [NEPTUNE] = 7.78f,
-    };
+    return true;
+}
 
-    unsigned int i;
-    for (i = 0; i < NUM_PLANETS; ++i)
+bool generate_star_soa(struct star_soa *star_soa, const struct packed_star *packed_table, const int *star_numbers,
+                       unsigned int num_stars, struct arena *arena)
+{
+    const unsigned int num_arrays = 9;
+
+    // Carve every array out of a single allocation so the whole store is
+    // contiguous
+    double *block = arena_alloc(arena, num_arrays * num_stars * sizeof(double));
+    star_soa->table_index = arena_alloc(arena, num_stars * sizeof(unsigned int));
+    if (block == NULL || star_soa->table_index == NULL)
     {
-        struct planet temp_planet;
+        printf("Allocation of memory for star SoA failed\n");
+        return false;
+    }
 
-        temp_planet.base = (struct object_base){
-            .symbol_ASCII = planet_symbols_ASCII[i],
-            .symbol_unicode = NULL,
-            .label = NULL,
-            .color_pair = planet_colors[i],
-        };
+    star_soa->num_stars = num_stars;
+    star_soa->x = block;
+    star_soa->y = block + num_stars;
+    star_soa->z = block + 2 * num_stars;
+    star_soa->dx = block + 3 * num_stars;
+    star_soa->dy = block + 4 * num_stars;
+    star_soa->dz = block + 5 * num_stars;
+    star_soa->eq_x = block + 6 * num_stars;
+    star_soa->eq_y = block + 7 * num_stars;
+    star_soa->eq_z = block + 8 * num_stars;
+    star_soa->eq_julian_date = 0.0;
+    star_soa->eq_valid = false;
 
-        char *unicode_temp = (char *)planet_symbols_unicode[i];
-        char *label_temp = (char *)planet_labels[i];
+    for (unsigned int i = 0; i < num_stars; ++i)
+    {
+        unsigned int table_index = (unsigned int)(star_numbers[i] - 1);
 
-        if (unicode_temp != NULL)
-        {
-            temp_planet.base.symbol_unicode = malloc(strlen(unicode_temp) + 1);
-            if (temp_planet.base.symbol_unicode == NULL)
-            {
-                return false;
-            }
-            strcpy(temp_planet.base.symbol_unicode, unicode_temp);
-        }
+        star_soa->table_index[i] = table_index;
 
-        if (label_temp != NULL)
-        {
-            temp_planet.base.label = malloc(strlen(label_temp) + 1);
-            if (temp_planet.base.label == NULL)
-            {
-                return false;
-            }
-            strcpy(temp_planet.base.label, label_temp);
-        }
+        double right_ascension, declination, ra_motion, dec_motion;
+        unpack_star(&packed_table[table_index], &right_ascension, &declination, &ra_motion, &dec_motion);
 
-        temp_planet.elements = &planet_elements[i];
-        temp_planet.rates = &planet_rates[i];
-        temp_planet.magnitude = planet_mean_mags[i];
+        double sin_ra = sin(right_ascension);
+        double cos_ra = cos(right_ascension);
+        double sin_dec = sin(declination);
+        double cos_dec = cos(declination);
 
-        if (JUPITER <= i && i <= NEPTUNE)
-        {
-            temp_planet.extras = &planet_extras[i];
-        }
-        else
-        {
-            temp_planet.extras = NULL;
-        }
+        star_soa->x[i] = cos_dec * cos_ra;
+        star_soa->y[i] = cos_dec * sin_ra;
+        star_soa->z[i] = sin_dec;
 
-        (*planet_table)[i] = temp_planet;
+        // Derivative of the unit vector with respect to time, i.e. the partial
+        // derivatives with respect to right ascension and declination weighted
+        // by the respective proper motions
+        star_soa->dx[i] = -cos_dec * sin_ra * ra_motion - sin_dec * cos_ra * dec_motion;
+        star_soa->dy[i] = cos_dec * cos_ra * ra_motion - sin_dec * sin_ra * dec_motion;
+        star_soa->dz[i] = cos_dec * dec_motion;
     }
 
     return true;
 }
 
-bool generate_moon_object(struct moon *moon_data, const struct kep_elems *moon_elements, const struct kep_rates *moon_rates)
-{
-    moon_data->base = (struct object_base){
-        .symbol_ASCII = 'M',
-        .symbol_unicode = "🌝︎︎",
-        .label = "Moon",
-        .color_pair = 0,
-    };
-
-    moon_data->elements = moon_elements;
-    moon_data->rates = moon_rates;
-    moon_data->magnitude = 0.0f; // TODO: fix this value
+// Sky index cells are 10° declination bands split into 10° right ascension
+// sectors
+#define SKY_DEC_BANDS 18
+#define SKY_RA_SECTORS 36
 
-    return true;
+/* Apply a permutation to an array of doubles, such that array[i] becomes
+ * array[perm[i]], using `scratch` as temporary storage
+ */
+static void permute_doubles(double *array, const unsigned int *perm, unsigned int size, double *scratch)
+{
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        scratch[i] = array[perm[i]];
+    }
+    memcpy(array, scratch, size * sizeof(double));
 }
 
-// TODO: verify this catches the first and last entries
-bool generate_name_table(const uint8_t *data, size_t data_len, struct star_name **name_table_out, int num_stars)
+bool generate_sky_index(struct sky_index *sky_index, struct star_soa *star_soa, const struct constell *constell_table,
+                        unsigned int num_const, struct arena *arena)
 {
-    *name_table_out = malloc(num_stars * sizeof(struct star_name));
-    if (*name_table_out == NULL)
+    const unsigned int num_sky_cells = SKY_DEC_BANDS * SKY_RA_SECTORS;
+    const unsigned int num_cells = num_sky_cells + 1; // Plus the never culled cell
+    const unsigned int pinned_cell = num_sky_cells;
+    const unsigned int num_stars = star_soa->num_stars;
+
+    sky_index->num_cells = num_cells;
+    sky_index->cell_start = arena_alloc(arena, (num_cells + 1) * sizeof(unsigned int));
+    sky_index->center_x = arena_alloc(arena, 4 * num_cells * sizeof(double));
+    sky_index->visible = arena_alloc(arena, num_cells * sizeof(bool));
+
+    // Scratch arrays only live until the index is built, so they are not
+    // allocated from the arena
+    unsigned int *star_cell = malloc(num_stars * sizeof(unsigned int));
+    unsigned int *perm = malloc(num_stars * sizeof(unsigned int));
+    double *scratch = malloc(num_stars * sizeof(double));
+
+    // Mark constellation stars by star table index
+    unsigned int num_table_stars = 0;
+    for (unsigned int i = 0; i < num_stars; ++i)
     {
-        printf("Allocation of memory for name table failed\n");
-        return false;
+        if (star_soa->table_index[i] + 1 > num_table_stars)
+        {
+            num_table_stars = star_soa->table_index[i] + 1;
+        }
     }
+    bool *pinned = calloc(num_table_stars + 1, sizeof(bool));
 
-    const unsigned BUF_SIZE = 32; // More than enough room to store any line
-    char buffer[BUF_SIZE];
-    size_t offset = 0;
-
-    // Fill array with NULL pointers to start
-    for (int i = 0; i < num_stars; ++i)
+    if (sky_index->cell_start == NULL || sky_index->center_x == NULL || sky_index->visible == NULL || star_cell == NULL ||
+        perm == NULL || scratch == NULL || pinned == NULL)
     {
-        (*name_table_out)[i].name = NULL;
+        printf("Allocation of memory for sky index failed\n");
+        free(star_cell);
+        free(perm);
+        free(scratch);
+        free(pinned);
+        return false;
     }
 
-    // Set desired indices with names
-    while (offset < data_len)
+    memset(sky_index->cell_start, 0, (num_cells + 1) * sizeof(unsigned int));
+
+    sky_index->center_y = sky_index->center_x + num_cells;
+    sky_index->center_z = sky_index->center_x + 2 * num_cells;
+    sky_index->sin_radius = sky_index->center_x + 3 * num_cells;
+
+    for (unsigned int i = 0; i < num_const; ++i)
     {
-        // Find the next line in the embedded data (similar to fgets)
-        size_t i = 0;
-        while (offset + i < data_len && data[offset + i] != '\n' && i < BUF_SIZE - 1)
+        for (unsigned int j = 0; j < constell_table[i].num_segments * 2; ++j)
         {
-            buffer[i] = data[offset + i];
-            i++;
+            unsigned int table_index = (unsigned int)(constell_table[i].star_numbers[j] - 1);
+            if (table_index < num_table_stars)
+            {
+                pinned[table_index] = true;
+            }
         }
-        buffer[i] = '\0'; // Null terminate the string
+    }
 
-        // If we haven't reached the end of the buffer, move to the next line
-        offset += i + 1; // Move past the newline character
+    const double band_height = M_PI / SKY_DEC_BANDS;
+    const double sector_width = 2.0 * M_PI / SKY_RA_SECTORS;
 
-        if (buffer[0] == '\0')
+    // Cell centers
+    for (unsigned int band = 0; band < SKY_DEC_BANDS; ++band)
+    {
+        double dec = -M_PI / 2.0 + (band + 0.5) * band_height;
+        for (unsigned int sector = 0; sector < SKY_RA_SECTORS; ++sector)
         {
-            continue; // Skip empty lines
+            double ra = (sector + 0.5) * sector_width;
+            unsigned int cell = band * SKY_RA_SECTORS + sector;
+            sky_index->center_x[cell] = cos(dec) * cos(ra);
+            sky_index->center_y[cell] = cos(dec) * sin(ra);
+            sky_index->center_z[cell] = sin(dec);
         }
+    }
+    sky_index->center_x[pinned_cell] = 0.0;
+    sky_index->center_y[pinned_cell] = 0.0;
+    sky_index->center_z[pinned_cell] = 1.0;
 
-        // Split by delimiter (expecting the format "catalog_number,name")
-        int catalog_number = atoi(strtok(buffer, ","));
-        char *name = strtok(NULL, ",\n");
-
-        int table_index = catalog_number - 1;
-
-        struct star_name temp_name;
-        temp_name.name = malloc(strlen(name) + 1);
-        if (temp_name.name == NULL)
+    // Assign every slot to a cell and count cell sizes
+    for (unsigned int i = 0; i < num_stars; ++i)
+    {
+        unsigned int cell;
+        if (pinned[star_soa->table_index[i]])
         {
-            return false;
+            cell = pinned_cell;
         }
-        strcpy(temp_name.name, name);
+        else
+        {
+            double dec = asin(star_soa->z[i]);
+            double ra = atan2(star_soa->y[i], star_soa->x[i]);
+            if (ra < 0.0)
+            {
+                ra += 2.0 * M_PI;
+            }
 
-        (*name_table_out)[table_index] = temp_name;
-    }
+            int band = (int)((dec + M_PI / 2.0) / band_height);
+            int sector = (int)(ra / sector_width);
+            band = band < 0 ? 0 : (band >= SKY_DEC_BANDS ? SKY_DEC_BANDS - 1 : band);
+            sector = sector < 0 ? 0 : (sector >= SKY_RA_SECTORS ? SKY_RA_SECTORS - 1 : sector);
 
-    return true;
-}
+            cell = (unsigned int)band * SKY_RA_SECTORS + (unsigned int)sector;
+        }
 
-/* Parse a single constellation entry, e.g.:
- *
- * CVn 1 4915 4785
- *
- * Adds the entry *constell_table_out[line_number]:
- *
- * struct constell
- * {
- * num_segments=1
- * int *star_numbers=[4915, 4785]
- * };
- *
- * NOTE: line numbers are 0-indexed
- */
-bool parse_line(const uint8_t *data, struct constell **constell_table_out, int line_start, int line_end, int line_number)
-{
-    // Validate the input range
-    if (line_end <= line_start || data == NULL || constell_table_out == NULL)
-    {
-        return false;
+        star_cell[i] = cell;
+        sky_index->cell_start[cell + 1]++;
     }
 
-    // Create a temporary buffer for the line data
-    size_t line_length = line_end - line_start + 1;
-    char buffer[line_length + 1]; // +1 for null-terminator
-
-    // Copy the relevant data into the buffer (ensure null-termination)
-    memcpy(buffer, &data[line_start], line_length);
-    buffer[line_length] = '\0';
-
-    // Parse the line:
-    char *name = strtok(buffer, " "); // First token is the constellation name
-    if (name == NULL)
+    for (unsigned int cell = 0; cell < num_cells; ++cell)
     {
-        return false; // Malformed line, no name found
+        sky_index->cell_start[cell + 1] += sky_index->cell_start[cell];
     }
 
-    // The next token is the number of segments
-    char *num_segments_str = strtok(NULL, " ");
-    if (num_segments_str == NULL)
+    // Counting sort of slots by cell, preserving the relative order of stars
+    // within a cell
+    unsigned int *fill = malloc(num_cells * sizeof(unsigned int));
+    if (fill == NULL)
     {
-        return false; // Malformed line, no number of segments
+        printf("Allocation of memory for sky index failed\n");
+        free(star_cell);
+        free(perm);
+        free(scratch);
+        free(pinned);
+        return false;
     }
-
-    unsigned int num_segments = atoi(num_segments_str);
-    if (num_segments == 0)
+    memcpy(fill, sky_index->cell_start, num_cells * sizeof(unsigned int));
+    for (unsigned int i = 0; i < num_stars; ++i)
     {
-        return false; // Invalid number of segments
+        perm[fill[star_cell[i]]++] = i;
     }
 
-    // Allocate memory for the star numbers
-    int *star_numbers = malloc(num_segments * 2 * sizeof(int)); // Each segment has two star numbers
-    if (star_numbers == NULL)
+    // Reorder the SoA
+    double *arrays[] = {star_soa->x, star_soa->y, star_soa->z, star_soa->dx, star_soa->dy, star_soa->dz};
+    for (unsigned int a = 0; a < sizeof(arrays) / sizeof(arrays[0]); ++a)
     {
-        return false; // Memory allocation failed
+        permute_doubles(arrays[a], perm, num_stars, scratch);
     }
-
-    // Parse the star numbers (expecting num_segments * 2 star numbers)
-    unsigned int i = 0;
-    char *token;
-    while ((token = strtok(NULL, " ")) != NULL && i < num_segments * 2)
+    for (unsigned int i = 0; i < num_stars; ++i)
     {
-        star_numbers[i] = atoi(token);
-        ++i;
+        star_cell[i] = star_soa->table_index[perm[i]];
     }
+    memcpy(star_soa->table_index, star_cell, num_stars * sizeof(unsigned int));
+    star_soa->eq_valid = false;
 
-    // If we didn't get enough star numbers, it's an error
-    if (i != num_segments * 2)
+    sky_index_fit_cells(sky_index, star_soa->x, star_soa->y, star_soa->z);
+    for (unsigned int cell = 0; cell < num_cells; ++cell)
     {
-        free(star_numbers);
-        return false; // Malformed line, not enough star numbers
+        sky_index->visible[cell] = true;
     }
 
-    // Allocate memory for the constellations table if necessary
-    if (*constell_table_out == NULL)
+    free(fill);
+    free(star_cell);
+    free(perm);
+    free(scratch);
+    free(pinned);
+
+    return true;
+}
+
+void sky_index_fit_cells(struct sky_index *sky_index, const double *x, const double *y, const double *z)
+{
+    // Small margin for rounding and for positions that are not exactly unit
+    const double margin = 1.0E-6;
+
+    // The last cell is never culled
+    unsigned int last_cell = sky_index->num_cells - 1;
+    sky_index->sin_radius[last_cell] = 2.0;
+
+    for (unsigned int cell = 0; cell < last_cell; ++cell)
     {
-        *constell_table_out = malloc(sizeof(struct constell) * (line_number + 1));
-        if (*constell_table_out == NULL)
+        double cx = sky_index->center_x[cell];
+        double cy = sky_index->center_y[cell];
+        double cz = sky_index->center_z[cell];
+
+        // Cosine of the largest angular distance from the center
+        double min_dot = 1.0;
+        for (unsigned int i = sky_index->cell_start[cell]; i < sky_index->cell_start[cell + 1]; ++i)
         {
-            free(star_numbers);
-            return false; // Memory allocation failed for the table
+            double dot = cx * x[i] + cy * y[i] + cz * z[i];
+            if (dot < min_dot)
+            {
+                min_dot = dot;
+            }
         }
+
+        // Caps of 90° or more can never be culled
+        sky_index->sin_radius[cell] = min_dot > 0.0 ? sqrt(1.0 - min_dot * min_dot) + margin : 2.0;
     }
-    else
+}
+
+bool generate_frame_positions(struct frame_positions *positions, unsigned int num_stars, unsigned int num_cells)
+{
+    positions->julian_date = 0.0;
+    positions->star_azimuth = malloc(2 * (num_stars + 1) * sizeof(double));
+    positions->cell_visible = calloc(num_cells + 1, sizeof(bool));
+
+    if (positions->star_azimuth == NULL || positions->cell_visible == NULL)
     {
-        // Reallocate memory to accommodate new constellations
-        *constell_table_out = realloc(*constell_table_out, sizeof(struct constell) * (line_number + 1));
-        if (*constell_table_out == NULL)
-        {
-            free(star_numbers);
-            return false; // Memory allocation failed for the table
-        }
+        printf("Allocation of memory for frame positions failed\n");
+        free_frame_positions(positions);
+        return false;
     }
 
-    // Store the parsed constellation in the correct table location
-    struct constell temp_constell = {.num_segments = num_segments, .star_numbers = star_numbers};
-
-    (*constell_table_out)[line_number] = temp_constell;
+    positions->star_altitude = positions->star_azimuth + num_stars + 1;
 
     return true;
 }
 
-bool generate_constell_table(const uint8_t *data, size_t data_len, struct constell **constell_table_out,
-                             unsigned int *num_constell_out)
+bool generate_planet_table(struct planet **planet_table, const struct kep_elems *planet_elements,
+                           const struct kep_rates *planet_rates, const struct kep_extra *planet_extras,
+                           struct arena *arena)
 {
-    // Validate input
-    if (data == NULL || constell_table_out == NULL || num_constell_out == NULL || data_len == 0)
+    *planet_table = arena_alloc(arena, NUM_PLANETS * sizeof(struct planet));
+    if (*planet_table == NULL)
     {
+        printf("Allocation of memory for planet table failed\n");
         return false;
     }
 
-    unsigned int num_constells = 0;
-    size_t line_start = 0;
-    size_t line_end = 0;
+    const char *planet_symbols_unicode[NUM_PLANETS] = {
+        [SUN] = "☉",     [MERCURY] = "☿", [VENUS] = "♀",  [EARTH] = "🜨",  [MARS] = "♂",
+        [JUPITER] = "♃", [SATURN] = "♄",  [URANUS] = "⛢", [NEPTUNE] = "♆"};
 
-    // Count the number of lines in the data
-    for (size_t i = 0; i < data_len; ++i)
-    {
-        if (data[i] == '\n')
-        {
-            num_constells++;
-        }
-    }
+    const char planet_symbols_ASCII[NUM_PLANETS] = {
+        [SUN] = '@',     [MERCURY] = '*', [VENUS] = '*',  [EARTH] = '*',  [MARS] = '*',
+        [JUPITER] = '*', [SATURN] = '*',  [URANUS] = '*', [NEPTUNE] = '*'};
 
-    // Allocate memory for the constellation table
-    *constell_table_out = malloc(num_constells * sizeof(struct constell));
-    if (*constell_table_out == NULL)
-    {
-        printf("Allocation of memory for constellation table failed\n");
-        return false;
-    }
+    const char *planet_labels[NUM_PLANETS] = {
+        [SUN] = "Sun",         [MERCURY] = "Mercury", [VENUS] = "Venus",   [EARTH] = "Earth",    [MARS] = "Mars",
+        [JUPITER] = "Jupiter", [SATURN] = "Saturn",   [URANUS] = "Uranus", [NEPTUNE] = "Neptune"};
 
-    const unsigned BUF_SIZE = 256;
-    char buffer[BUF_SIZE];
-    size_t offset = 0;
-    size_t i = 0; // Use size_t here for consistency with offset
+    // TODO: find better way to map these values
+    const int planet_colors[NUM_PLANETS] = {
+        [SUN] = 4, [MERCURY] = 8, [VENUS] = 4, [MARS] = 2, [JUPITER] = 6, [SATURN] = 4, [URANUS] = 7, [NEPTUNE] = 5,
+    };
 
-    // Parse each line of data
-    int line_number = 0;
-    for (size_t i = 0; i < data_len; ++i)
+    // TODO: compute these values...?
+    const float planet_mean_mags[NUM_PLANETS] = {
+        [SUN] = -26.832f,   [MERCURY] = 0.23f, [VENUS] = -4.14f, [MARS] = 0.71f,
+        [JUPITER] = -2.20f, [SATURN] = 0.46f,  [URANUS] = 5.68f, [NEPTUNE] = 7.78f,
+    };
+
+    unsigned int i;
+    for (i = 0; i < NUM_PLANETS; ++i)
     {
-        // Find the start of the current line
-        if (i == 0 || data[i - 1] == '\n')
-        {
-            line_start = i;
-        }
+        struct planet temp_planet;
 
-        // Find the end of the current line
-        if (i == data_len - 1 || data[i] == '\n')
-        {
-            line_end = i;
+        temp_planet.base = (struct object_base){
+            .symbol_ASCII = planet_symbols_ASCII[i],
+            .symbol_unicode = planet_symbols_unicode[i],
+            .label = planet_labels[i],
+            .color_pair = planet_colors[i],
+        };
 
-            // Parse the line and store the parsed constellation in the table
-            if (!parse_line(data, constell_table_out, line_start, line_end, line_number))
-            {
-                printf("Failed to parse line %d\n", line_number);
-                return false;
-            }
+        temp_planet.elements = &planet_elements[i];
+        temp_planet.rates = &planet_rates[i];
+        temp_planet.magnitude = planet_mean_mags[i];
 
-            line_number++; // Increment line number
+        if (JUPITER <= i && i <= NEPTUNE)
+        {
+            temp_planet.extras = &planet_extras[i];
+        }
+        else
+        {
+            temp_planet.extras = NULL;
         }
-    }
 
-    // Set the number of constellations in the output parameter
-    *num_constell_out = num_constells;
+        (*planet_table)[i] = temp_planet;
+    }
 
     return true;
 }
 
-// Memory freeing
-
-static void free_base_members(struct object_base base)
+bool generate_moon_object(struct moon *moon_data, const struct kep_elems *moon_elements, const struct kep_rates *moon_rates)
 {
-    if (base.symbol_unicode != NULL)
-    {
-        free(base.symbol_unicode);
-    }
-    if (base.label != NULL)
-    {
-        free(base.label);
-    }
-    return;
-}
+    moon_data->base = (struct object_base){
+        .symbol_ASCII = 'M',
+        .symbol_unicode = "🌝︎︎",
+        .label = "Moon",
+        .color_pair = 0,
+    };
 
-void free_constell_members(struct constell constell_data)
-{
-    if (constell_data.star_numbers != NULL)
-    {
-        free(constell_data.star_numbers);
-    }
-    return;
-}
+    moon_data->elements = moon_elements;
+    moon_data->rates = moon_rates;
+    moon_data->magnitude = 0.0f; // TODO: fix this value
 
-void free_star_name_members(struct star_name name_data)
-{
-    if (name_data.name != NULL)
-    {
-        free(name_data.name);
-    }
-    return;
+    return true;
 }
 
-void free_stars(struct star *star_table, unsigned int size)
-{
-    for (unsigned int i = 0; i < size; ++i)
-    {
-        free_base_members(star_table[i].base);
-    }
-    free(star_table);
-    return;
-}
+// Memory freeing
 
-void free_planets(struct planet *planets, unsigned int size)
+void free_frame_positions(struct frame_positions *positions)
 {
-    for (unsigned int i = 0; i < size; ++i)
-    {
-        free_base_members(planets[i].base);
-    }
-    free(planets);
+    // Altitudes share the allocation starting at star_azimuth
+    free(positions->star_azimuth);
+    free(positions->cell_visible);
+    positions->star_azimuth = NULL;
+    positions->star_altitude = NULL;
+    positions->cell_visible = NULL;
     return;
 }
 
@@ -492,26 +549,6 @@ void free_moon_object(struct moon moon_data)
     return;
 }
 
-void free_constells(struct constell *constell_table, unsigned int size)
-{
-    for (unsigned int i = 0; i < size; i++)
-    {
-        free_constell_members(constell_table[i]);
-    }
-    free(constell_table);
-    return;
-}
-
-void free_star_names(struct star_name *name_table, unsigned int size)
-{
-    for (unsigned int i = 0; i < size; ++i)
-    {
-        free_star_name_members(name_table[i]);
-    }
-    free(name_table);
-    return;
-}
-
 // Miscellaneous
 
 int star_magnitude_comparator(const void *v1, const void *v2)
@@ -519,18 +556,24 @@ int star_magnitude_comparator(const void *v1, const void *v2)
     const struct star *p1 = (struct star *)v1;
     const struct star *p2 = (struct star *)v2;
 
-    // Lower magnitudes are brighter
+    // Lower magnitudes are brighter. Ties are broken by catalog number, since
+    // qsort is not stable and the generated catalog must match this order
     if (p1->magnitude < p2->magnitude)
         return +1;
     else if (p1->magnitude > p2->magnitude)
         return -1;
+    else if (p1->catalog_number < p2->catalog_number)
+        return -1;
+    else if (p1->catalog_number > p2->catalog_number)
+        return +1;
     else
         return 0;
 }
 
-bool star_numbers_by_magnitude(int **num_by_mag, struct star *star_table, unsigned int num_stars)
+bool star_numbers_by_magnitude(int **num_by_mag, struct star *star_table, unsigned int num_stars,
+                               struct arena *arena)
 {
-    // Create and sort a copy of the star table
+    // Create and sort a temporary copy of the star table
     struct star *table_copy = malloc(num_stars * sizeof(struct star));
     if (table_copy == NULL)
     {
@@ -542,10 +585,11 @@ bool star_numbers_by_magnitude(int **num_by_mag, struct star *star_table, unsign
     qsort(table_copy, num_stars, sizeof(struct star), star_magnitude_comparator);
 
     // Create and fill array of indicies in table copy
-    *num_by_mag = malloc(num_stars * sizeof(int));
-    if (num_by_mag == NULL)
+    *num_by_mag = arena_alloc(arena, num_stars * sizeof(int));
+    if (*num_by_mag == NULL)
     {
         printf("Allocation of memory for num by mag array  failed\n");
+        free(table_copy);
         return false;
     }
 
@@ -559,6 +603,27 @@ bool star_numbers_by_magnitude(int **num_by_mag, struct star *star_table, unsign
     return true;
 }
 
+unsigned int star_magnitude_cutoff(const struct star *star_table, const int *num_by_mag, unsigned int num_stars,
+                                   float threshold)
+{
+    // Binary search for the first star at or below the threshold
+    unsigned int low = 0;
+    unsigned int high = num_stars;
+    while (low < high)
+    {
+        unsigned int mid = low + (high - low) / 2;
+        if (star_table[num_by_mag[mid] - 1].magnitude > threshold)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 int map_float_to_int_range(double min_float, double max_float, int min_int, int max_int, double input)
 {
     double percent = (input - min_float) / (max_float - min_float);
@@ -3,36 +3,234 @@
 #include "astro.h"
 #include "coord.h"
 #include "core.h"
+#include "ephemeris.h"
 
 #include <math.h>
+#include <stdbool.h>
 
-void update_star_positions(struct star *star_table, int num_stars, double julian_date, double latitude, double longitude)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Number of stars handled per pass of the position kernel. Intermediate values
+// for a block live in stack buffers small enough to stay in L1
+#define STAR_BLOCK_SIZE 256
+
+/* Linear stage of the star position kernel. Propagates the cached J2000 unit
+ * vectors of stars [begin, begin + count) by their proper motion velocity,
+ * which is a multiply-add per component and is vectorized where the target
+ * supports it. The results are renormalized, since linear propagation moves
+ * them off the unit sphere
+ */
+static void star_block_propagate(const struct star_soa *star_soa, unsigned int begin, unsigned int count, double years,
+                                 double *x, double *y, double *z)
 {
-    double gmst = greenwich_mean_sidereal_time_rad(julian_date);
+    const double *x0 = &star_soa->x[begin];
+    const double *y0 = &star_soa->y[begin];
+    const double *z0 = &star_soa->z[begin];
+    const double *dx = &star_soa->dx[begin];
+    const double *dy = &star_soa->dy[begin];
+    const double *dz = &star_soa->dz[begin];
 
-    int i;
-    for (i = 0; i < num_stars; ++i)
+    unsigned int i = 0;
+
+#if defined(__AVX2__)
+    const __m256d v_years = _mm256_set1_pd(years);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm256_storeu_pd(&x[i], _mm256_add_pd(_mm256_loadu_pd(&x0[i]), _mm256_mul_pd(_mm256_loadu_pd(&dx[i]), v_years)));
+        _mm256_storeu_pd(&y[i], _mm256_add_pd(_mm256_loadu_pd(&y0[i]), _mm256_mul_pd(_mm256_loadu_pd(&dy[i]), v_years)));
+        _mm256_storeu_pd(&z[i], _mm256_add_pd(_mm256_loadu_pd(&z0[i]), _mm256_mul_pd(_mm256_loadu_pd(&dz[i]), v_years)));
+    }
+#elif defined(__SSE2__)
+    const __m128d v_years = _mm_set1_pd(years);
+    for (; i + 2 <= count; i += 2)
+    {
+        _mm_storeu_pd(&x[i], _mm_add_pd(_mm_loadu_pd(&x0[i]), _mm_mul_pd(_mm_loadu_pd(&dx[i]), v_years)));
+        _mm_storeu_pd(&y[i], _mm_add_pd(_mm_loadu_pd(&y0[i]), _mm_mul_pd(_mm_loadu_pd(&dy[i]), v_years)));
+        _mm_storeu_pd(&z[i], _mm_add_pd(_mm_loadu_pd(&z0[i]), _mm_mul_pd(_mm_loadu_pd(&dz[i]), v_years)));
+    }
+#endif
+
+    // Scalar fallback and remainder
+    for (; i < count; ++i)
+    {
+        x[i] = x0[i] + dx[i] * years;
+        y[i] = y0[i] + dy[i] * years;
+        z[i] = z0[i] + dz[i] * years;
+    }
+
+    // Stars only move along a tangent, so the error grows with the square of
+    // the distance travelled and matters for fast stars far from J2000.
+    // Propagation is rare, so this keeps the per-frame rotation to an asin
+    for (i = 0; i < count; ++i)
+    {
+        double scale = 1.0 / sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        x[i] *= scale;
+        y[i] *= scale;
+        z[i] *= scale;
+    }
+}
+
+/* Rotate star_soa slots [begin, end) to horizontal coordinates
+ */
+static void star_range_rotate(const struct star_soa *star_soa, unsigned int begin, unsigned int end,
+                              const struct frame_transform *transform, struct frame_positions *positions)
+{
+    for (; begin < end; begin += STAR_BLOCK_SIZE)
+    {
+        unsigned int count = end - begin;
+        if (count > STAR_BLOCK_SIZE)
+        {
+            count = STAR_BLOCK_SIZE;
+        }
+
+        frame_transform_unit_vectors(transform, &star_soa->eq_x[begin], &star_soa->eq_y[begin], &star_soa->eq_z[begin],
+                                     count, &positions->star_azimuth[begin], &positions->star_altitude[begin]);
+    }
+}
+
+// Arguments shared by the star update tasks run on the thread pool
+struct star_task
+{
+    struct star_soa *star_soa;
+    const struct sky_index *sky_index;
+    const struct frame_transform *transform;
+    struct frame_positions *positions;
+    double years;
+};
+
+/* Propagate proper motion for slots [begin, end)
+ */
+static void star_task_propagate(void *data, unsigned int begin, unsigned int end)
+{
+    struct star_task *task = data;
+    struct star_soa *star_soa = task->star_soa;
+
+    for (; begin < end; begin += STAR_BLOCK_SIZE)
+    {
+        unsigned int count = end - begin;
+        if (count > STAR_BLOCK_SIZE)
+        {
+            count = STAR_BLOCK_SIZE;
+        }
+
+        star_block_propagate(star_soa, begin, count, task->years, &star_soa->eq_x[begin], &star_soa->eq_y[begin],
+                             &star_soa->eq_z[begin]);
+    }
+}
+
+/* Rotate slots [begin, end) that lie in visible cells of the sky index, or
+ * all of them if there is no index
+ */
+static void star_task_rotate(void *data, unsigned int begin, unsigned int end)
+{
+    struct star_task *task = data;
+    const struct sky_index *sky_index = task->sky_index;
+
+    if (sky_index == NULL)
+    {
+        star_range_rotate(task->star_soa, begin, end, task->transform, task->positions);
+        return;
+    }
+
+    // Find the first cell overlapping the range
+    unsigned int low = 0;
+    unsigned int high = sky_index->num_cells;
+    while (low < high)
+    {
+        unsigned int mid = low + (high - low) / 2;
+        if (sky_index->cell_start[mid + 1] <= begin)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    for (unsigned int cell = low; cell < sky_index->num_cells && sky_index->cell_start[cell] < end; ++cell)
     {
-        struct star *star = &star_table[i];
+        if (!task->positions->cell_visible[cell])
+        {
+            continue;
+        }
 
-        double right_ascension, declination;
-        calc_star_position(star->right_ascension, star->ra_motion, star->declination, star->dec_motion, julian_date,
-                           &right_ascension, &declination);
+        unsigned int cell_begin = sky_index->cell_start[cell];
+        unsigned int cell_end = sky_index->cell_start[cell + 1];
 
-        // Convert to horizontal coordinates
-        double azimuth, altitude;
-        equatorial_to_horizontal(right_ascension, declination, gmst, latitude, longitude, &azimuth, &altitude);
+        cell_begin = cell_begin > begin ? cell_begin : begin;
+        cell_end = cell_end < end ? cell_end : end;
 
-        star->base.azimuth = azimuth;
-        star->base.altitude = altitude;
+        star_range_rotate(task->star_soa, cell_begin, cell_end, task->transform, task->positions);
     }
+}
+
+void update_star_positions(struct frame_positions *positions, struct star_soa *star_soa, struct sky_index *sky_index,
+                           struct thread_pool *pool, double julian_date, double pm_interval,
+                           const struct frame_transform *transform)
+{
+    const double J2000 = 2451545.0;        // J2000 epoch in julian days
+    const double days_per_year = 365.2425; // Average number of days per year
+
+    struct star_task task = {
+        .star_soa = star_soa,
+        .sky_index = sky_index,
+        .transform = transform,
+        .positions = positions,
+        .years = (julian_date - J2000) / days_per_year,
+    };
+
+    // Proper motion over a few frames is far below what can be displayed, so
+    // only re-propagate once the cached vectors are pm_interval days old
+    if (!star_soa->eq_valid || fabs(julian_date - star_soa->eq_julian_date) >= pm_interval)
+    {
+        thread_pool_run(pool, star_task_propagate, &task, star_soa->num_stars);
+
+        star_soa->eq_julian_date = julian_date;
+        star_soa->eq_valid = true;
+
+        if (sky_index != NULL)
+        {
+            sky_index_fit_cells(sky_index, star_soa->eq_x, star_soa->eq_y, star_soa->eq_z);
+        }
+    }
+
+    if (sky_index != NULL)
+    {
+        // The zenith in equatorial coordinates is the last row of the transform
+        const double *zenith = transform->matrix[2];
+
+        for (unsigned int cell = 0; cell < sky_index->num_cells; ++cell)
+        {
+            // A cell is entirely below the horizon when its bounding cap is
+            // more than 90° from the zenith
+            double dot = zenith[0] * sky_index->center_x[cell] + zenith[1] * sky_index->center_y[cell] +
+                         zenith[2] * sky_index->center_z[cell];
+            positions->cell_visible[cell] = dot >= -sky_index->sin_radius[cell];
+        }
+    }
+
+    // Slots are partitioned between threads, each writing to distinct entries
+    // of the buffer. thread_pool_run returns once all are done
+    thread_pool_run(pool, star_task_rotate, &task, star_soa->num_stars);
 
     return;
 }
 
-void update_planet_positions(struct planet *planet_table, double julian_date, double latitude, double longitude)
+void update_planet_positions(struct frame_positions *positions, struct planet_ephemeris *ephemeris, double julian_date,
+                             const struct frame_transform *transform)
 {
-    double gmst = greenwich_mean_sidereal_time_rad(julian_date);
+    // Heliocentric coordinates of the Earth-Moon barycenter
+    double xe, ye, ze;
+    planet_ephemeris_helio_ICRF(ephemeris, EARTH, julian_date, &xe, &ye, &ze);
 
     int i;
     for (i = SUN; i < NUM_PLANETS; ++i)
@@ -40,11 +238,6 @@ void update_planet_positions(struct planet *planet_table, double julian_date, do
         // Geocentric rectangular equatorial coordinates
         double xg, yg, zg;
 
-        // Heliocentric coordinates of the Earth-Moon barycenter
-        double xe, ye, ze;
-        calc_planet_helio_ICRF(planet_table[EARTH].elements, planet_table[EARTH].rates, planet_table[EARTH].extras, julian_date,
-                               &xe, &ye, &ze);
-
         if (i == SUN)
         {
             // Since the origin of the ICRF frame is the barycenter of the Solar
@@ -57,8 +250,7 @@ void update_planet_positions(struct planet *planet_table, double julian_date, do
         }
         else
         {
-            calc_planet_helio_ICRF(planet_table[i].elements, planet_table[i].rates, planet_table[i].extras, julian_date, &xg,
-                                   &yg, &zg);
+            planet_ephemeris_helio_ICRF(ephemeris, i, julian_date, &xg, &yg, &zg);
 
             // Obtain geocentric coordinates by subtracting Earth's coordinates
             xg -= xe;
@@ -66,34 +258,91 @@ void update_planet_positions(struct planet *planet_table, double julian_date, do
             zg -= ze;
         }
 
-        // Convert to spherical equatorial coordinates
-        double right_ascension, declination;
-        equatorial_rectangular_to_spherical(xg, yg, zg, &right_ascension, &declination);
+        frame_transform_apply(transform, xg, yg, zg, &positions->planet_azimuth[i], &positions->planet_altitude[i]);
+    }
+}
 
-        double azimuth, altitude;
-        equatorial_to_horizontal(right_ascension, declination, gmst, latitude, longitude, &azimuth, &altitude);
+void update_moon_position(struct frame_positions *positions, const struct moon *moon_object,
+                          struct orbit_rotation *rotation, double julian_date, const struct frame_transform *transform)
+{
+    double xg, yg, zg;
+    calc_moon_geo_ICRF(moon_object->elements, moon_object->rates, julian_date, rotation, &xg, &yg, &zg);
 
-        planet_table[i].base.azimuth = azimuth;
-        planet_table[i].base.altitude = altitude;
-    }
+    frame_transform_apply(transform, xg, yg, zg, &positions->moon_azimuth, &positions->moon_altitude);
+
+    return;
 }
 
-void update_moon_position(struct moon *moon_object, double julian_date, double latitude, double longitude)
+void update_frame_positions(struct frame_positions *positions, struct star_soa *star_soa, struct sky_index *sky_index,
+                            struct thread_pool *pool, struct planet_ephemeris *ephemeris, const struct moon *moon_object,
+                            double latitude, double longitude, double pm_interval, double julian_date)
 {
+    // The equatorial to horizontal rotation only depends on the time and
+    // observer, so it is built once per frame
+    struct frame_transform transform;
     double gmst = greenwich_mean_sidereal_time_rad(julian_date);
+    frame_transform_init(&transform, gmst, latitude, longitude);
 
-    double xg, yg, zg;
-    calc_moon_geo_ICRF(moon_object->elements, moon_object->rates, julian_date, &xg, &yg, &zg);
+    positions->julian_date = julian_date;
+
+    update_star_positions(positions, star_soa, sky_index, pool, julian_date, pm_interval, &transform);
+    update_planet_positions(positions, ephemeris, julian_date, &transform);
+    update_moon_position(positions, moon_object, &ephemeris->moon_rotation, julian_date, &transform);
+
+    return;
+}
+
+void apply_frame_positions(const struct frame_positions *positions, struct star *star_table,
+                           const struct star_soa *star_soa, struct sky_index *sky_index, struct planet *planet_table,
+                           struct moon *moon_object)
+{
+    if (sky_index == NULL)
+    {
+        for (unsigned int i = 0; i < star_soa->num_stars; ++i)
+        {
+            struct star *star = &star_table[star_soa->table_index[i]];
+            star->base.azimuth = positions->star_azimuth[i];
+            star->base.altitude = positions->star_altitude[i];
+        }
+    }
+    else
+    {
+        for (unsigned int cell = 0; cell < sky_index->num_cells; ++cell)
+        {
+            unsigned int cell_begin = sky_index->cell_start[cell];
+            unsigned int cell_end = sky_index->cell_start[cell + 1];
 
-    // Convert to spherical equatorial coordinates
-    double right_ascension, declination;
-    equatorial_rectangular_to_spherical(xg, yg, zg, &right_ascension, &declination);
+            if (positions->cell_visible[cell])
+            {
+                for (unsigned int i = cell_begin; i < cell_end; ++i)
+                {
+                    struct star *star = &star_table[star_soa->table_index[i]];
+                    star->base.azimuth = positions->star_azimuth[i];
+                    star->base.altitude = positions->star_altitude[i];
+                }
+            }
+            else if (sky_index->visible[cell])
+            {
+                // The cell just set. Move its stars to the nadir once so stale
+                // positions are not rendered
+                for (unsigned int i = cell_begin; i < cell_end; ++i)
+                {
+                    star_table[star_soa->table_index[i]].base.altitude = -M_PI / 2.0;
+                }
+            }
 
-    double azimuth, altitude;
-    equatorial_to_horizontal(right_ascension, declination, gmst, latitude, longitude, &azimuth, &altitude);
+            sky_index->visible[cell] = positions->cell_visible[cell];
+        }
+    }
+
+    for (int i = SUN; i < NUM_PLANETS; ++i)
+    {
+        planet_table[i].base.azimuth = positions->planet_azimuth[i];
+        planet_table[i].base.altitude = positions->planet_altitude[i];
+    }
 
-    moon_object->base.azimuth = azimuth;
-    moon_object->base.altitude = altitude;
+    moon_object->base.azimuth = positions->moon_azimuth;
+    moon_object->base.altitude = positions->moon_altitude;
 
     return;
 }
@@ -119,9 +368,7 @@ void update_moon_phase(struct moon *moon_object, double julian_date, double lati
     }
 
     int phase_index = map_float_to_int_range(0.0, 1.0, 0, NUM_PHASES - 1, phase);
-    char *moon_char = (char *)moon_phases[phase_index];
-
-    moon_object->base.symbol_unicode = moon_char;
+    moon_object->base.symbol_unicode = moon_phases[phase_index];
 
     return;
 }
@@ -12,6 +12,11 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Fastest apparent motion of any rendered object in radians per day: one
+// sidereal rotation of the sky per sidereal day, plus the Moon's motion of one
+// revolution per sidereal month
+#define MAX_SKY_RATE (2.0 * M_PI * (1.00273790935 + 1.0 / 27.321661))
+
 void horizontal_to_polar(double azimuth, double altitude, double *radius, double *theta)
 {
     double theta_sphere, phi_sphere;
@@ -24,6 +29,13 @@ void horizontal_to_polar(double azimuth, double altitude, double *radius, double
 
 void render_object_stereo(WINDOW *win, struct object_base *object, struct conf *config)
 {
+    // Objects below the horizon project outside the unit circle, so reject
+    // them before doing any projection work
+    if (object->altitude < 0.0)
+    {
+        return;
+    }
+
     double radius_polar, theta_polar;
     horizontal_to_polar(object->azimuth, object->altitude, &radius_polar, &theta_polar);
 
@@ -32,12 +44,6 @@ void render_object_stereo(WINDOW *win, struct object_base *object, struct conf *
     getmaxyx(win, height, width);
     polar_to_win(radius_polar, theta_polar, height, width, &y, &x);
 
-    // If outside projection, ignore
-    if (fabs(radius_polar) > 1)
-    {
-        return;
-    }
-
     bool use_color = config->color_flag && object->color_pair != 0;
 
     if (use_color)
@@ -70,7 +76,7 @@ void render_object_stereo(WINDOW *win, struct object_base *object, struct conf *
     return;
 }
 
-void render_stars_stereo(WINDOW *win, struct conf *config, struct star *star_table, int num_stars, int *num_by_mag)
+void render_stars_stereo(WINDOW *win, struct conf *config, struct star *star_table, int num_stars, const int *num_by_mag)
 {
     int i;
     for (i = 0; i < num_stars; ++i)
@@ -80,11 +86,6 @@ void render_stars_stereo(WINDOW *win, struct conf *config, struct star *star_tab
 
         struct star *star = &star_table[table_index];
 
-        if (star->magnitude > config->threshold)
-        {
-            continue;
-        }
-
         // FIXME: this is hacky
         if (star->magnitude > config->label_thresh)
         {
@@ -366,3 +367,18 @@ void render_cardinal_directions(WINDOW *win, struct conf *config)
         wattroff(win, COLOR_PAIR(5));
     }
 }
+
+double render_stereo_days_per_cells(WINDOW *win, double cells)
+{
+    int height, width;
+    getmaxyx(win, height, width);
+
+    // Radius of the projection's unit circle in cells, see polar_to_win
+    double cells_per_radian = ((height > width ? height : width) - 1) / 2.0;
+    if (cells_per_radian <= 0.0)
+    {
+        cells_per_radian = 1.0;
+    }
+
+    return cells / (cells_per_radian * MAX_SKY_RATE);
+}
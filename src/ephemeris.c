@@ -0,0 +1,117 @@
+#include "ephemeris.h"
+
+#include "astro.h"
+#include "core.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void planet_ephemeris_init(struct planet_ephemeris *ephemeris, const struct planet *planet_table)
+{
+    ephemeris->planet_table = planet_table;
+    ephemeris->valid = false;
+    ephemeris->segment_start = 0.0;
+    for (int p = 0; p < NUM_PLANETS; ++p)
+    {
+        ephemeris->rotations[p].valid = false;
+    }
+    ephemeris->moon_rotation.valid = false;
+}
+
+/* Fit every planet over the segment starting at `segment_start`. The model is
+ * sampled at the Chebyshev nodes of the segment, where the coefficients follow
+ * from a discrete cosine transform of the samples
+ */
+static void fit_segment(struct planet_ephemeris *ephemeris, double segment_start)
+{
+    const int n = EPHEMERIS_NUM_COEFFS;
+    const double half_span = EPHEMERIS_SEGMENT_DAYS / 2.0;
+    const double midpoint = segment_start + half_span;
+
+    double node_dates[EPHEMERIS_NUM_COEFFS];
+    for (int j = 0; j < n; ++j)
+    {
+        node_dates[j] = midpoint + half_span * cos(M_PI * (j + 0.5) / n);
+    }
+
+    double samples[NUM_PLANETS][3][EPHEMERIS_NUM_COEFFS];
+    for (int p = 0; p < NUM_PLANETS; ++p)
+    {
+        const struct planet *planet = &ephemeris->planet_table[p];
+        calc_planet_helio_ICRF_epochs(planet->elements, planet->rates, planet->extras, node_dates, n,
+                                      &ephemeris->rotations[p], samples[p][0], samples[p][1], samples[p][2]);
+    }
+
+    for (int k = 0; k < n; ++k)
+    {
+        double weights[EPHEMERIS_NUM_COEFFS];
+        for (int j = 0; j < n; ++j)
+        {
+            weights[j] = 2.0 / n * cos(M_PI * k * (j + 0.5) / n);
+        }
+
+        for (int p = 0; p < NUM_PLANETS; ++p)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                double sum = 0.0;
+                for (int j = 0; j < n; ++j)
+                {
+                    sum += weights[j] * samples[p][c][j];
+                }
+                ephemeris->coeffs[p][c][k] = sum;
+            }
+        }
+    }
+
+    // The series is evaluated as a plain sum, so halve the constant term once
+    // here rather than on every evaluation
+    for (int p = 0; p < NUM_PLANETS; ++p)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            ephemeris->coeffs[p][c][0] /= 2.0;
+        }
+    }
+
+    ephemeris->segment_start = segment_start;
+    ephemeris->valid = true;
+}
+
+/* Evaluate a Chebyshev series at `x` in [-1, 1] with Clenshaw's recurrence
+ */
+static double evaluate_series(const double *coeffs, double x)
+{
+    double b1 = 0.0;
+    double b2 = 0.0;
+    for (int k = EPHEMERIS_NUM_COEFFS - 1; k >= 1; --k)
+    {
+        double b0 = 2.0 * x * b1 - b2 + coeffs[k];
+        b2 = b1;
+        b1 = b0;
+    }
+    return x * b1 - b2 + coeffs[0];
+}
+
+void planet_ephemeris_helio_ICRF(struct planet_ephemeris *ephemeris, enum planets planet, double julian_date, double *xh,
+                                 double *yh, double *zh)
+{
+    double offset = julian_date - ephemeris->segment_start;
+    if (!ephemeris->valid || offset < 0.0 || offset > EPHEMERIS_SEGMENT_DAYS)
+    {
+        // Segments are aligned to multiples of their length, so stepping back
+        // and forth around a boundary refits at most one segment each time
+        fit_segment(ephemeris, floor(julian_date / EPHEMERIS_SEGMENT_DAYS) * EPHEMERIS_SEGMENT_DAYS);
+        offset = julian_date - ephemeris->segment_start;
+    }
+
+    double x = offset / (EPHEMERIS_SEGMENT_DAYS / 2.0) - 1.0;
+
+    *xh = evaluate_series(ephemeris->coeffs[planet][0], x);
+    *yh = evaluate_series(ephemeris->coeffs[planet][1], x);
+    *zh = evaluate_series(ephemeris->coeffs[planet][2], x);
+}
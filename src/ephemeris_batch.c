@@ -0,0 +1,212 @@
+#include "ephemeris_batch.h"
+
+#include "astro.h"
+#include "coord.h"
+#include "core.h"
+#include "thread_pool.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Epochs handled per pass. Intermediate values for a block live in stack
+// buffers small enough to stay in L1
+#define BATCH_BLOCK_SIZE 256
+
+// Arguments shared by the batch tasks run on the thread pool
+struct batch_task
+{
+    const struct planet *planet_table;
+    const struct moon *moon_object;
+    unsigned int body_set;
+    const double *julian_dates;
+    unsigned int count;
+    double latitude;
+    double longitude;
+    const struct batch_positions *output;
+};
+
+unsigned int batch_num_bodies(unsigned int body_set)
+{
+    unsigned int num_bodies = 0;
+    for (int body = 0; body < BATCH_NUM_BODIES; ++body)
+    {
+        if (body_set & BATCH_BODY(body))
+        {
+            ++num_bodies;
+        }
+    }
+    return num_bodies;
+}
+
+/* Write the positions of one body at epochs [begin, begin + block_count) from
+ * its geocentric rectangular equatorial coordinates. `offset` is the index of
+ * the body's first entry in the output arrays
+ */
+static void batch_block_write(const struct batch_task *task, const struct frame_transform *transforms,
+                              unsigned int begin, unsigned int block_count, size_t offset, const double *xg,
+                              const double *yg, const double *zg)
+{
+    const struct batch_positions *output = task->output;
+
+    if (output->right_ascension != NULL || output->declination != NULL)
+    {
+        for (unsigned int j = 0; j < block_count; ++j)
+        {
+            double right_ascension, declination;
+            equatorial_rectangular_to_spherical(xg[j], yg[j], zg[j], &right_ascension, &declination);
+            if (right_ascension < 0.0)
+            {
+                right_ascension += 2.0 * M_PI;
+            }
+
+            if (output->right_ascension != NULL)
+            {
+                output->right_ascension[offset + begin + j] = right_ascension;
+            }
+            if (output->declination != NULL)
+            {
+                output->declination[offset + begin + j] = declination;
+            }
+        }
+    }
+
+    if (output->azimuth != NULL || output->altitude != NULL)
+    {
+        for (unsigned int j = 0; j < block_count; ++j)
+        {
+            double azimuth, altitude;
+            frame_transform_apply(&transforms[j], xg[j], yg[j], zg[j], &azimuth, &altitude);
+
+            if (output->azimuth != NULL)
+            {
+                output->azimuth[offset + begin + j] = azimuth;
+            }
+            if (output->altitude != NULL)
+            {
+                output->altitude[offset + begin + j] = altitude;
+            }
+        }
+    }
+}
+
+/* Compute every body of the set at epochs [begin, begin + block_count),
+ * block_count <= BATCH_BLOCK_SIZE
+ */
+static void batch_block_compute(const struct batch_task *task, unsigned int begin, unsigned int block_count)
+{
+    const double *dates = &task->julian_dates[begin];
+    const struct batch_positions *output = task->output;
+
+    // The equatorial to horizontal rotation of each epoch is shared by all
+    // bodies
+    struct frame_transform transforms[BATCH_BLOCK_SIZE];
+    if (output->azimuth != NULL || output->altitude != NULL)
+    {
+        for (unsigned int j = 0; j < block_count; ++j)
+        {
+            double gmst = greenwich_mean_sidereal_time_rad(dates[j]);
+            frame_transform_init(&transforms[j], gmst, task->latitude, task->longitude);
+        }
+    }
+
+    // Heliocentric coordinates of the Earth-Moon barycenter
+    double xe[BATCH_BLOCK_SIZE], ye[BATCH_BLOCK_SIZE], ze[BATCH_BLOCK_SIZE];
+    if (task->body_set & (BATCH_ALL_BODIES & ~BATCH_BODY(BATCH_MOON)))
+    {
+        const struct planet *earth = &task->planet_table[EARTH];
+        struct orbit_rotation rotation = {.valid = false};
+        calc_planet_helio_ICRF_epochs(earth->elements, earth->rates, earth->extras, dates, block_count, &rotation, xe,
+                                      ye, ze);
+    }
+
+    double xg[BATCH_BLOCK_SIZE], yg[BATCH_BLOCK_SIZE], zg[BATCH_BLOCK_SIZE];
+    size_t offset = 0;
+
+    for (int body = 0; body < BATCH_NUM_BODIES; ++body)
+    {
+        if (!(task->body_set & BATCH_BODY(body)))
+        {
+            continue;
+        }
+
+        struct orbit_rotation rotation = {.valid = false};
+
+        if (body == SUN)
+        {
+            // The geocentric position of the Sun is the negated heliocentric
+            // position of the Earth, see update_planet_positions
+            for (unsigned int j = 0; j < block_count; ++j)
+            {
+                xg[j] = -xe[j];
+                yg[j] = -ye[j];
+                zg[j] = -ze[j];
+            }
+        }
+        else if (body == BATCH_MOON)
+        {
+            const struct moon *moon_object = task->moon_object;
+            for (unsigned int j = 0; j < block_count; ++j)
+            {
+                calc_moon_geo_ICRF(moon_object->elements, moon_object->rates, dates[j], &rotation, &xg[j], &yg[j],
+                                   &zg[j]);
+            }
+        }
+        else
+        {
+            const struct planet *planet = &task->planet_table[body];
+            calc_planet_helio_ICRF_epochs(planet->elements, planet->rates, planet->extras, dates, block_count,
+                                          &rotation, xg, yg, zg);
+            for (unsigned int j = 0; j < block_count; ++j)
+            {
+                xg[j] -= xe[j];
+                yg[j] -= ye[j];
+                zg[j] -= ze[j];
+            }
+        }
+
+        batch_block_write(task, transforms, begin, block_count, offset, xg, yg, zg);
+        offset += task->count;
+    }
+}
+
+/* Compute epochs [begin, end)
+ */
+static void batch_task_compute(void *data, unsigned int begin, unsigned int end)
+{
+    const struct batch_task *task = data;
+
+    for (; begin < end; begin += BATCH_BLOCK_SIZE)
+    {
+        unsigned int block_count = end - begin;
+        if (block_count > BATCH_BLOCK_SIZE)
+        {
+            block_count = BATCH_BLOCK_SIZE;
+        }
+
+        batch_block_compute(task, begin, block_count);
+    }
+}
+
+void ephemeris_batch_compute(const struct planet *planet_table, const struct moon *moon_object, unsigned int body_set,
+                             const double *julian_dates, unsigned int count, double latitude, double longitude,
+                             struct thread_pool *pool, const struct batch_positions *output)
+{
+    struct batch_task task = {
+        .planet_table = planet_table,
+        .moon_object = moon_object,
+        .body_set = body_set & BATCH_ALL_BODIES,
+        .julian_dates = julian_dates,
+        .count = count,
+        .latitude = latitude,
+        .longitude = longitude,
+        .output = output,
+    };
+
+    // Each thread writes to its own range of epochs of every body
+    thread_pool_run(pool, batch_task_compute, &task, count);
+}
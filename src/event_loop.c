@@ -0,0 +1,230 @@
+// POSIX clocks, signals and poll
+#define _POSIX_C_SOURCE 200809L
+
+#include "event_loop.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#endif
+
+// Write end of the SIGWINCH pipe, for the signal handler
+static int winch_write_fd = -1;
+
+static void catch_winch(int sig)
+{
+    int saved_errno = errno;
+    char byte = 0;
+    ssize_t result = write(winch_write_fd, &byte, 1);
+    (void)result; // A full pipe already has a resize pending
+    errno = saved_errno;
+}
+
+/* Set up a pipe that becomes readable after SIGWINCH
+ */
+static bool init_signal_pipe(struct event_loop *loop)
+{
+    int fds[2];
+    if (pipe(fds) == -1)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    loop->signal_fd = fds[0];
+    loop->signal_write_fd = fds[1];
+    winch_write_fd = fds[1];
+
+    struct sigaction action;
+    action.sa_handler = catch_winch;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return sigaction(SIGWINCH, &action, NULL) == 0;
+}
+
+bool event_loop_init(struct event_loop *loop, int input_fd)
+{
+    loop->input_fd = input_fd;
+    loop->timer_fd = -1;
+    loop->signal_fd = -1;
+    loop->signal_write_fd = -1;
+    clock_gettime(CLOCK_MONOTONIC, &loop->start);
+    loop->deadline = loop->start;
+
+#if defined(__linux__)
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    // SIGWINCH is blocked so it is only ever delivered through the signalfd.
+    // Threads created afterwards inherit the mask
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGWINCH);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) == 0)
+    {
+        loop->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    }
+#endif
+
+    if (loop->signal_fd == -1 && !init_signal_pipe(loop))
+    {
+        printf("Unable to watch for terminal resizes\n");
+        event_loop_free(loop);
+        return false;
+    }
+
+    return true;
+}
+
+void event_loop_schedule(struct event_loop *loop, unsigned long interval)
+{
+    loop->deadline.tv_sec += interval / 1000000;
+    loop->deadline.tv_nsec += (long)(interval % 1000000) * 1000;
+    if (loop->deadline.tv_nsec >= 1000000000)
+    {
+        loop->deadline.tv_sec += 1;
+        loop->deadline.tv_nsec -= 1000000000;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (loop->deadline.tv_sec < now.tv_sec ||
+        (loop->deadline.tv_sec == now.tv_sec && loop->deadline.tv_nsec < now.tv_nsec))
+    {
+        loop->deadline = now;
+    }
+
+#if defined(__linux__)
+    if (loop->timer_fd != -1)
+    {
+        // One shot at the absolute deadline. A zero value would disarm the
+        // timer, and is never passed since CLOCK_MONOTONIC is past zero
+        struct itimerspec timer = {
+            .it_interval = {0, 0},
+            .it_value = loop->deadline,
+        };
+        timerfd_settime(loop->timer_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+    }
+#endif
+}
+
+double event_loop_elapsed(const struct event_loop *loop)
+{
+    return (double)(loop->deadline.tv_sec - loop->start.tv_sec) + (loop->deadline.tv_nsec - loop->start.tv_nsec) / 1.0E9;
+}
+
+/* Return the poll timeout in milliseconds until the deadline, rounded up so
+ * the deadline has passed once it runs out. Long waits are split up
+ */
+static int poll_timeout(const struct event_loop *loop)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    long long remaining = (long long)(loop->deadline.tv_sec - now.tv_sec) * 1000000000LL +
+                          (loop->deadline.tv_nsec - now.tv_nsec);
+    if (remaining <= 0)
+    {
+        return 0;
+    }
+
+    long long milliseconds = (remaining + 999999) / 1000000;
+    return milliseconds > 60000 ? 60000 : (int)milliseconds;
+}
+
+/* Empty a non-blocking file descriptor
+ */
+static void drain(int fd)
+{
+    char buffer[256];
+    while (read(fd, buffer, sizeof(buffer)) > 0)
+    {
+    }
+}
+
+enum event_type event_loop_wait(struct event_loop *loop)
+{
+    while (true)
+    {
+        struct pollfd fds[3] = {
+            {.fd = loop->signal_fd, .events = POLLIN},
+            {.fd = loop->input_fd, .events = POLLIN}, // Negative descriptors are ignored
+            {.fd = loop->timer_fd, .events = POLLIN},
+        };
+        nfds_t num_fds = loop->timer_fd != -1 ? 3 : 2;
+        int timeout = loop->timer_fd != -1 ? -1 : poll_timeout(loop);
+
+        int num_ready = poll(fds, num_fds, timeout);
+        if (num_ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // Nothing sensible can be waited on, so fall back to drawing frames
+            return EVENT_FRAME;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            drain(loop->signal_fd);
+            return EVENT_RESIZE;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            return EVENT_INPUT;
+        }
+        if (fds[1].revents & (POLLHUP | POLLERR | POLLNVAL))
+        {
+            // Without input there is nothing left to read, and polling it
+            // would return immediately forever
+            loop->input_fd = -1;
+        }
+
+        if (num_fds == 3 && (fds[2].revents & POLLIN))
+        {
+            drain(loop->timer_fd);
+            return EVENT_FRAME;
+        }
+
+        if (num_fds == 2 && poll_timeout(loop) == 0)
+        {
+            return EVENT_FRAME;
+        }
+    }
+}
+
+void event_loop_free(struct event_loop *loop)
+{
+    if (loop->timer_fd != -1)
+    {
+        close(loop->timer_fd);
+    }
+    if (loop->signal_fd != -1)
+    {
+        close(loop->signal_fd);
+    }
+    if (loop->signal_write_fd != -1)
+    {
+        close(loop->signal_write_fd);
+        winch_write_fd = -1;
+    }
+    loop->timer_fd = -1;
+    loop->signal_fd = -1;
+    loop->signal_write_fd = -1;
+}
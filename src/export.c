@@ -0,0 +1,330 @@
+#include "export.h"
+
+#include "coord.h"
+#include "core.h"
+#include "core_position.h"
+#include "ephemeris_batch.h"
+#include "thread_pool.h"
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Output is sent in writes of about this many bytes
+#define EXPORT_BUFFER_SIZE (1 << 20)
+
+// Longest formatted record or header, in either format
+#define EXPORT_MAX_RECORD 128
+
+// Dates whose Solar System positions are computed in one batch
+#define EXPORT_BLOCK_SIZE 256
+
+// Decimal places of Julian dates and angles in CSV output, about 0.1 s and
+// 0.004"
+#define EXPORT_CSV_DECIMALS 6
+
+bool export_writer_init(struct export_writer *writer, int fd, enum export_format format)
+{
+    writer->fd = fd;
+    writer->format = format;
+    writer->length = 0;
+    writer->capacity = EXPORT_BUFFER_SIZE;
+    writer->failed = false;
+    writer->buffer = malloc(writer->capacity);
+
+    if (writer->buffer == NULL)
+    {
+        fprintf(stderr, "Allocation of memory for export buffer failed\n");
+        return false;
+    }
+
+    const char *header =
+        format == EXPORT_CSV ? "julian_date,object,right_ascension,declination,azimuth,altitude\n" : EXPORT_BINARY_MAGIC;
+    memcpy(writer->buffer, header, strlen(header));
+    writer->length = strlen(header);
+
+    return true;
+}
+
+bool export_writer_flush(struct export_writer *writer)
+{
+    size_t written = 0;
+    while (!writer->failed && written < writer->length)
+    {
+        ssize_t result = write(writer->fd, writer->buffer + written, writer->length - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // Non-blocking output is full, so sleep until it drains
+                struct pollfd output = {.fd = writer->fd, .events = POLLOUT};
+                if (poll(&output, 1, -1) >= 0 || errno == EINTR)
+                {
+                    continue;
+                }
+            }
+
+            writer->failed = true;
+            break;
+        }
+        written += (size_t)result;
+    }
+
+    writer->length = 0;
+    return !writer->failed;
+}
+
+void export_writer_free(struct export_writer *writer)
+{
+    free(writer->buffer);
+    writer->buffer = NULL;
+}
+
+/* Make room for one more record
+ */
+static void export_reserve(struct export_writer *writer)
+{
+    if (writer->capacity - writer->length < EXPORT_MAX_RECORD)
+    {
+        export_writer_flush(writer);
+    }
+}
+
+static void append_bytes(struct export_writer *writer, const void *bytes, size_t length)
+{
+    memcpy(writer->buffer + writer->length, bytes, length);
+    writer->length += length;
+}
+
+static void append_char(struct export_writer *writer, char c)
+{
+    writer->buffer[writer->length++] = c;
+}
+
+static void append_unsigned(struct export_writer *writer, unsigned long long value)
+{
+    char digits[20];
+    int n = 0;
+    do
+    {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (n > 0)
+    {
+        append_char(writer, digits[--n]);
+    }
+}
+
+/* Append `value` with EXPORT_CSV_DECIMALS decimal places. This is much faster
+ * than printf, which dominates CSV output otherwise. |value| must be below
+ * 1.0E12
+ */
+static void append_fixed(struct export_writer *writer, double value)
+{
+    const unsigned long long scale = 1000000; // 10^EXPORT_CSV_DECIMALS
+
+    bool negative = value < 0.0;
+    unsigned long long scaled = (unsigned long long)(fabs(value) * scale + 0.5);
+
+    if (negative && scaled != 0)
+    {
+        append_char(writer, '-');
+    }
+    append_unsigned(writer, scaled / scale);
+    append_char(writer, '.');
+
+    char *fraction = writer->buffer + writer->length;
+    unsigned long long remainder = scaled % scale;
+    for (int d = EXPORT_CSV_DECIMALS - 1; d >= 0; --d)
+    {
+        fraction[d] = (char)('0' + remainder % 10);
+        remainder /= 10;
+    }
+    writer->length += EXPORT_CSV_DECIMALS;
+}
+
+/* Start the records of one date
+ */
+static void export_date(struct export_writer *writer, double julian_date, uint32_t num_records)
+{
+    if (writer->format == EXPORT_BINARY)
+    {
+        export_reserve(writer);
+        append_bytes(writer, &julian_date, sizeof(julian_date));
+        append_bytes(writer, &num_records, sizeof(num_records));
+    }
+}
+
+/* Write one object's position, with angles in radians. `name` is used in
+ * place of `id` in CSV output if it is not NULL
+ */
+static void export_record(struct export_writer *writer, double julian_date, int32_t id, const char *name,
+                          double right_ascension, double declination, double azimuth, double altitude)
+{
+    const double to_deg = 180.0 / M_PI;
+
+    export_reserve(writer);
+
+    if (writer->format == EXPORT_BINARY)
+    {
+        float angles[4] = {(float)(right_ascension * to_deg), (float)(declination * to_deg), (float)(azimuth * to_deg),
+                           (float)(altitude * to_deg)};
+        append_bytes(writer, &id, sizeof(id));
+        append_bytes(writer, angles, sizeof(angles));
+        return;
+    }
+
+    append_fixed(writer, julian_date);
+    append_char(writer, ',');
+    if (name != NULL)
+    {
+        append_bytes(writer, name, strlen(name));
+    }
+    else
+    {
+        append_unsigned(writer, (unsigned long long)id);
+    }
+    append_char(writer, ',');
+    append_fixed(writer, right_ascension * to_deg);
+    append_char(writer, ',');
+    append_fixed(writer, declination * to_deg);
+    append_char(writer, ',');
+    append_fixed(writer, azimuth * to_deg);
+    append_char(writer, ',');
+    append_fixed(writer, altitude * to_deg);
+    append_char(writer, '\n');
+}
+
+bool export_positions(struct export_writer *writer, struct star_soa *star_soa, const struct star *star_table,
+                      const struct planet *planet_table, const struct moon *moon_object, struct thread_pool *pool,
+                      double latitude, double longitude, double pm_interval, double start_julian_date, double step,
+                      unsigned long num_dates)
+{
+    // The Earth is the observer, so it is left out
+    const unsigned int body_set = BATCH_ALL_BODIES & ~BATCH_BODY(EARTH);
+    const unsigned int num_bodies = batch_num_bodies(body_set);
+    const unsigned int num_stars = star_soa->num_stars;
+
+    struct frame_positions positions;
+    if (!generate_frame_positions(&positions, num_stars, 0))
+    {
+        return false;
+    }
+
+    // Star right ascensions and declinations only change when proper motion is
+    // re-applied, so they are cached alongside the propagated vectors
+    double *star_coords = malloc(2 * (num_stars + 1) * sizeof(double));
+    double *body_coords = malloc(4 * num_bodies * EXPORT_BLOCK_SIZE * sizeof(double));
+    if (star_coords == NULL || body_coords == NULL)
+    {
+        fprintf(stderr, "Allocation of memory for export failed\n");
+        free(star_coords);
+        free(body_coords);
+        free_frame_positions(&positions);
+        return false;
+    }
+
+    double *star_right_ascension = star_coords;
+    double *star_declination = star_coords + num_stars + 1;
+    double star_coords_julian_date = 0.0;
+    bool star_coords_valid = false;
+
+    struct batch_positions bodies = {
+        .right_ascension = body_coords,
+        .declination = body_coords + num_bodies * EXPORT_BLOCK_SIZE,
+        .azimuth = body_coords + 2 * num_bodies * EXPORT_BLOCK_SIZE,
+        .altitude = body_coords + 3 * num_bodies * EXPORT_BLOCK_SIZE,
+    };
+
+    double dates[EXPORT_BLOCK_SIZE];
+
+    for (unsigned long begin = 0; begin < num_dates && !writer->failed; begin += EXPORT_BLOCK_SIZE)
+    {
+        unsigned int count = num_dates - begin < EXPORT_BLOCK_SIZE ? (unsigned int)(num_dates - begin) : EXPORT_BLOCK_SIZE;
+
+        // Dates are computed from the start rather than accumulated, so they
+        // don't drift over long ranges
+        for (unsigned int j = 0; j < count; ++j)
+        {
+            dates[j] = start_julian_date + (double)(begin + j) * step;
+        }
+
+        ephemeris_batch_compute(planet_table, moon_object, body_set, dates, count, latitude, longitude, pool, &bodies);
+
+        for (unsigned int j = 0; j < count; ++j)
+        {
+            struct frame_transform transform;
+            frame_transform_init(&transform, greenwich_mean_sidereal_time_rad(dates[j]), latitude, longitude);
+
+            // Every star is positioned, including those below the horizon
+            update_star_positions(&positions, star_soa, NULL, pool, dates[j], pm_interval, &transform);
+
+            if (!star_coords_valid || star_soa->eq_julian_date != star_coords_julian_date)
+            {
+                for (unsigned int i = 0; i < num_stars; ++i)
+                {
+                    equatorial_rectangular_to_spherical(star_soa->eq_x[i], star_soa->eq_y[i], star_soa->eq_z[i],
+                                                        &star_right_ascension[i], &star_declination[i]);
+                    if (star_right_ascension[i] < 0.0)
+                    {
+                        star_right_ascension[i] += 2.0 * M_PI;
+                    }
+                }
+                star_coords_julian_date = star_soa->eq_julian_date;
+                star_coords_valid = true;
+            }
+
+            export_date(writer, dates[j], num_stars + num_bodies);
+
+            for (unsigned int i = 0; i < num_stars; ++i)
+            {
+                const struct star *star = &star_table[star_soa->table_index[i]];
+                export_record(writer, dates[j], star->catalog_number, NULL, star_right_ascension[i],
+                              star_declination[i], positions.star_azimuth[i], positions.star_altitude[i]);
+            }
+
+            // Batch output holds `count` dates of each body in turn
+            unsigned int slot = 0;
+            for (int body = 0; body < BATCH_NUM_BODIES; ++body)
+            {
+                if (!(body_set & BATCH_BODY(body)))
+                {
+                    continue;
+                }
+
+                bool moon = body == BATCH_MOON;
+                int32_t id = moon ? EXPORT_MOON_ID : -1 - body;
+                const char *name = moon ? moon_object->base.label : planet_table[body].base.label;
+                unsigned int k = slot * count + j;
+
+                export_record(writer, dates[j], id, name, bodies.right_ascension[k], bodies.declination[k],
+                              bodies.azimuth[k], bodies.altitude[k]);
+                ++slot;
+            }
+        }
+    }
+
+    export_writer_flush(writer);
+
+    free(star_coords);
+    free(body_coords);
+    free_frame_positions(&positions);
+
+    return !writer->failed;
+}
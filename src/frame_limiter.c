@@ -0,0 +1,42 @@
+#include "frame_limiter.h"
+
+#include <stddef.h>
+
+// Weight of the newest frame in the moving average of write latency
+#define LATENCY_SMOOTHING 0.25
+
+// Largest fraction of each frame that may be spent writing output
+#define MAX_WRITE_FRACTION 0.5
+
+void frame_limiter_init(struct frame_limiter *limiter, double budget, double min_interval)
+{
+    limiter->budget = budget;
+    limiter->min_interval = min_interval;
+    limiter->average_latency = 0.0;
+}
+
+double frame_limiter_update(struct frame_limiter *limiter, size_t bytes, double latency)
+{
+    limiter->average_latency += LATENCY_SMOOTHING * (latency - limiter->average_latency);
+
+    double interval = limiter->min_interval;
+
+    // Time this frame's output takes at the budgeted rate
+    if (limiter->budget > 0.0)
+    {
+        double send_time = (double)bytes / limiter->budget;
+        if (send_time > interval)
+        {
+            interval = send_time;
+        }
+    }
+
+    // Back off while writes are slow
+    double write_time = limiter->average_latency / MAX_WRITE_FRACTION;
+    if (write_time > interval)
+    {
+        interval = write_time;
+    }
+
+    return interval;
+}
@@ -0,0 +1,136 @@
+#include "frame_pipeline.h"
+
+#include "core.h"
+#include "core_position.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Sleep until `flag` holds `value` or the pipeline is stopped. Returns
+ * immediately, without locking, when the flag is already set
+ */
+static void wait_for_flag(struct frame_pipeline *pipeline, int *flag, int value)
+{
+    if (__atomic_load_n(flag, __ATOMIC_ACQUIRE) == value)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pipeline->mutex);
+    while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) != value && !__atomic_load_n(&pipeline->stop, __ATOMIC_ACQUIRE))
+    {
+        pthread_cond_wait(&pipeline->changed, &pipeline->mutex);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/* Publish `value` to `flag` and wake the other thread if it is waiting on it
+ */
+static void set_flag(struct frame_pipeline *pipeline, int *flag, int value)
+{
+    __atomic_store_n(flag, value, __ATOMIC_RELEASE);
+
+    // Taking the mutex orders the broadcast after any waiter has checked the
+    // flag, so the wake-up cannot be missed
+    pthread_mutex_lock(&pipeline->mutex);
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void *compute_main(void *data)
+{
+    struct frame_pipeline *pipeline = data;
+    unsigned int index = 0;
+
+    while (true)
+    {
+        wait_for_flag(pipeline, &pipeline->full[index], 0);
+        if (__atomic_load_n(&pipeline->stop, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+
+        update_frame_positions(&pipeline->buffers[index], pipeline->star_soa, pipeline->sky_index, pipeline->pool,
+                               pipeline->ephemeris, pipeline->moon_object, pipeline->latitude, pipeline->longitude,
+                               pipeline->pm_interval, pipeline->julian_dates[index]);
+
+        set_flag(pipeline, &pipeline->full[index], 1);
+        index ^= 1;
+    }
+
+    return NULL;
+}
+
+bool frame_pipeline_start(struct frame_pipeline *pipeline, struct star_soa *star_soa, struct sky_index *sky_index,
+                          struct thread_pool *pool, struct planet_ephemeris *ephemeris, const struct moon *moon_object,
+                          const struct conf *config, double julian_step)
+{
+    unsigned int num_cells = sky_index != NULL ? sky_index->num_cells : 0;
+
+    pipeline->full[0] = 0;
+    pipeline->full[1] = 0;
+    pipeline->stop = 0;
+    pipeline->render_index = 0;
+
+    pipeline->star_soa = star_soa;
+    pipeline->sky_index = sky_index;
+    pipeline->pool = pool;
+    pipeline->ephemeris = ephemeris;
+    pipeline->moon_object = moon_object;
+    pipeline->latitude = config->latitude;
+    pipeline->longitude = config->longitude;
+    pipeline->pm_interval = config->pm_interval;
+    pipeline->julian_dates[0] = config->julian_date;
+    pipeline->julian_dates[1] = config->julian_date + julian_step;
+
+    if (!generate_frame_positions(&pipeline->buffers[0], star_soa->num_stars, num_cells))
+    {
+        return false;
+    }
+    if (!generate_frame_positions(&pipeline->buffers[1], star_soa->num_stars, num_cells))
+    {
+        free_frame_positions(&pipeline->buffers[0]);
+        return false;
+    }
+
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->changed, NULL);
+
+    if (pthread_create(&pipeline->thread, NULL, compute_main, pipeline) != 0)
+    {
+        printf("Creation of frame compute thread failed\n");
+        pthread_cond_destroy(&pipeline->changed);
+        pthread_mutex_destroy(&pipeline->mutex);
+        free_frame_positions(&pipeline->buffers[0]);
+        free_frame_positions(&pipeline->buffers[1]);
+        return false;
+    }
+
+    return true;
+}
+
+const struct frame_positions *frame_pipeline_acquire(struct frame_pipeline *pipeline)
+{
+    wait_for_flag(pipeline, &pipeline->full[pipeline->render_index], 1);
+    return &pipeline->buffers[pipeline->render_index];
+}
+
+void frame_pipeline_release(struct frame_pipeline *pipeline, double julian_date)
+{
+    // Published to the compute thread along with the empty flag
+    pipeline->julian_dates[pipeline->render_index] = julian_date;
+    set_flag(pipeline, &pipeline->full[pipeline->render_index], 0);
+    pipeline->render_index ^= 1;
+}
+
+void frame_pipeline_stop(struct frame_pipeline *pipeline)
+{
+    set_flag(pipeline, &pipeline->stop, 1);
+    pthread_join(pipeline->thread, NULL);
+
+    pthread_cond_destroy(&pipeline->changed);
+    pthread_mutex_destroy(&pipeline->mutex);
+    free_frame_positions(&pipeline->buffers[0]);
+    free_frame_positions(&pipeline->buffers[1]);
+}
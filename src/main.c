@@ -3,30 +3,38 @@
 #include "core_render.h"
 
 #include "data/keplerian_elements.h"
+#include "ephemeris.h"
+#include "event_loop.h"
+#include "export.h"
+#include "frame_limiter.h"
+#include "frame_pipeline.h"
 #include "parse_BSC5.h"
+#include "screen.h"
 #include "stopwatch.h"
 #include "term.h"
+#include "thread_pool.h"
 
-// Embedded data generated during build
-#include "bsc5_constellations.h"
-#include "bsc5_data.h"
-#include "bsc5_names.h"
+// Star catalog generated during build
+#include "bsc5_catalog.h"
 
 // Third part libraries
 #include "argtable3.h"
 
+#include <fcntl.h>
 #include <getopt.h>
 #include <locale.h>
-#include <signal.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-static volatile bool perform_resize = false;
-
-static void catch_winch(int sig);
-static void handle_resize(WINDOW *win);
+static void handle_resize(WINDOW *win, struct screen *screen);
+static bool handle_input(WINDOW *input_win);
 static void parse_options(int argc, char *argv[], struct conf *config);
 static void convert_options(struct conf *config);
+static int run_export(const struct conf *config, struct star_soa *star_soa, const struct star *star_table,
+                      const struct planet *planet_table, const struct moon *moon_object);
 
 int main(int argc, char *argv[])
 {
@@ -44,6 +52,19 @@ int main(int argc, char *argv[])
         .color_flag = false,
         .grid_flag = false,
         .constell_flag = false,
+        .pm_interval = 1.0,
+        .threads = 1,
+        .pipeline_flag = false,
+        .catalog_path = NULL,
+        .alloc_stats_flag = false,
+        .vt_flag = false,
+        .max_bandwidth = 0.0,
+        .skip_idle_flag = false,
+        .export_path = NULL,
+        .export_end_string_utc = NULL,
+        .export_end_julian_date = 0.0,
+        .export_step = 1.0 / 24.0,
+        .export_binary_flag = false,
     };
 
     // Parse command line args and convert to internal representations
@@ -53,32 +74,71 @@ int main(int argc, char *argv[])
     // Time for each frame in microseconds
     unsigned long dt = (unsigned long)(1.0 / config.fps * 1.0E6);
 
-    // Initialize data structs
-    unsigned int num_stars, num_const;
-
-    struct entry *BSC5_entries;
-    struct star_name *name_table;
-    struct constell *constell_table;
-    struct star *star_table;
+    // Simulated time runs `animation_mult` times as fast as real time from the
+    // start date. Each frame shows the sky at the moment it is due on the
+    // monotonic clock, so the two never drift apart however frames are paced
+    const double microsec_per_day = 24.0 * 60.0 * 60.0 * 1.0E6;
+    const double julian_rate = 1.0E6 / microsec_per_day * config.animation_mult; // Simulated days per second
+    const double start_julian_date = config.julian_date;
+
+    // With --max-bandwidth, frames are spaced out to keep terminal output
+    // under the budget and to back off when writes block. With --skip-idle,
+    // frames in which nothing could have visibly moved are skipped
+    struct frame_limiter limiter;
+    frame_limiter_init(&limiter, config.max_bandwidth, dt / 1.0E6);
+    unsigned long frame_interval = dt;
+
+    // Longest wait between frames with --skip-idle, in microseconds
+    const double max_idle_interval = 60.0 * 1.0E6;
+
+    // Initialize data structs. The star table, magnitude index and
+    // constellation table are precompiled into bsc5_catalog.h:
+    //
+    // struct star bsc5_catalog_stars[];
+    // const struct packed_star bsc5_catalog_packed[];
+    // const int bsc5_catalog_num_by_mag[];
+    // struct constell bsc5_catalog_constells[];
+    unsigned int num_stars = bsc5_catalog_num_stars;
+    unsigned int num_const = bsc5_catalog_num_constells;
+
+    struct star *star_table = bsc5_catalog_stars;
+    const struct packed_star *packed_table = bsc5_catalog_packed;
+    const int *num_by_mag = bsc5_catalog_num_by_mag;
+    struct constell *constell_table = bsc5_catalog_constells;
+    struct star_soa star_soa;
+    struct sky_index sky_index;
     struct planet *planet_table;
     struct moon moon_object;
-    int *num_by_mag;
+
+    // Everything built at startup lives until exit, so it is all allocated
+    // from one arena and freed with a single call
+    struct arena startup_arena;
+    arena_init(&startup_arena, 64 * 1024);
 
     // Track success of functions
     bool s = true;
 
-    // Generated BSC5 data during build in bsc5_xxx.h:
-    //
-    // uint8_t bsc5_xxx[];
-    // size_t bsc5_xxx_len;
-
-    s = s && parse_entries(bsc5_data, bsc5_data_len, &BSC5_entries, &num_stars);
-    s = s && generate_name_table(bsc5_names, bsc5_names_len, &name_table, num_stars);
-    s = s && generate_constell_table(bsc5_constellations, bsc5_constellations_len, &constell_table, &num_const);
-    s = s && generate_star_table(&star_table, BSC5_entries, name_table, num_stars);
-    s = s && generate_planet_table(&planet_table, planet_elements, planet_rates, planet_extras);
+    // An external catalog is memory mapped and only the stars above the
+    // threshold are loaded from it. Its stars are not numbered like BSC5, so
+    // constellation figures are not available
+    struct bsc5_view external_catalog;
+    if (config.catalog_path != NULL)
+    {
+        s = s && bsc5_view_map(&external_catalog, config.catalog_path);
+        struct packed_star *external_packed_table = NULL;
+        int *external_num_by_mag = NULL;
+        s = s && generate_bright_packed_star_table(&external_packed_table, &num_stars, &external_catalog,
+                                                   config.threshold, &startup_arena);
+        s = s && generate_star_table(&star_table, external_packed_table, num_stars, &startup_arena);
+        s = s && star_numbers_by_magnitude(&external_num_by_mag, star_table, num_stars, &startup_arena);
+        packed_table = external_packed_table;
+        num_by_mag = external_num_by_mag;
+        constell_table = NULL;
+        num_const = 0;
+    }
+
+    s = s && generate_planet_table(&planet_table, planet_elements, planet_rates, planet_extras, &startup_arena);
     s = s && generate_moon_object(&moon_object, &moon_elements, &moon_rates);
-    s = s && star_numbers_by_magnitude(&num_by_mag, star_table, num_stars);
 
     if (!s)
     {
@@ -86,13 +146,94 @@ int main(int argc, char *argv[])
         abort();
     }
 
-    // This memory is no longer needed
-    free(BSC5_entries);
-    free_star_names(name_table, num_stars);
+    if (config.catalog_path != NULL)
+    {
+        // The loaded stars were copied out of the mapping
+        bsc5_view_unmap(&external_catalog);
+    }
+
+    // Only stars above the threshold are positioned or rendered. They occupy
+    // the tail of the magnitude index
+    unsigned int mag_cutoff = star_magnitude_cutoff(star_table, num_by_mag, num_stars, config.threshold);
+    unsigned int num_visible = num_stars - mag_cutoff;
+    const int *visible_by_mag = num_by_mag + mag_cutoff;
+
+    // Constellation figure stars are never culled so segments crossing the
+    // horizon can still be clipped
+    struct constell *pinned_constells = config.constell_flag ? constell_table : NULL;
+    unsigned int num_pinned_constells = config.constell_flag ? num_const : 0;
+
+    s = s && generate_star_soa(&star_soa, packed_table, visible_by_mag, num_visible, &startup_arena);
+    s = s && generate_sky_index(&sky_index, &star_soa, pinned_constells, num_pinned_constells, &startup_arena);
+
+    if (!s)
+    {
+        abort();
+    }
+
+    // With --export, positions are streamed out without ever touching the
+    // terminal
+    if (config.export_path != NULL)
+    {
+        int status = run_export(&config, &star_soa, star_table, planet_table, &moon_object);
+
+        free_moon_object(moon_object);
+        if (config.alloc_stats_flag)
+        {
+            arena_print_stats(&startup_arena, "Startup arena");
+        }
+        arena_destroy(&startup_arena);
+
+        return status;
+    }
+
+    // Planet positions are interpolated from an ephemeris fitted every few
+    // simulated days
+    struct planet_ephemeris ephemeris;
+    planet_ephemeris_init(&ephemeris, planet_table);
+
+    // Frame clock, input and resize events. Set up before any threads are
+    // started, since they must not receive SIGWINCH
+    struct event_loop events;
+    if (!event_loop_init(&events, STDIN_FILENO))
+    {
+        abort();
+    }
+
+    // Worker threads for position updates, if requested
+    struct thread_pool worker_pool;
+    struct thread_pool *pool = NULL;
+    if (config.threads > 1)
+    {
+        if (!thread_pool_init(&worker_pool, (unsigned int)config.threads))
+        {
+            abort();
+        }
+        pool = &worker_pool;
+    }
+
+    // Object positions. With --pipeline, a compute thread fills the next
+    // frame's buffer while the current frame is rendered; otherwise each frame
+    // is computed into a single buffer right before it is rendered
+    struct frame_pipeline pipeline;
+    struct frame_positions positions;
+    if (config.pipeline_flag)
+    {
+        s = frame_pipeline_start(&pipeline, &star_soa, &sky_index, pool, &ephemeris, &moon_object, &config,
+                                 dt / 1.0E6 * julian_rate);
+    }
+    else
+    {
+        s = generate_frame_positions(&positions, star_soa.num_stars, sky_index.num_cells);
+    }
+
+    if (!s)
+    {
+        abort();
+    }
 
     // Terminal/System settings
-    setlocale(LC_ALL, "");         // Required for unicode rendering
-    signal(SIGWINCH, catch_winch); // Capture window resizes
+    setlocale(LC_ALL, ""); // Required for unicode rendering
 
     // Ncurses initialization
     ncurses_init(config.color_flag != 0);
@@ -101,78 +242,171 @@ int main(int argc, char *argv[])
     win_resize_square(win, get_cell_aspect_ratio());
     win_position_center(win);
 
+    // Frames are drawn offscreen and only the cells that changed are copied to
+    // the window, so it is never erased. With --vt they are written to the
+    // terminal directly instead, and the window only marks where they go
+    struct screen screen;
+    int win_height, win_width;
+    getmaxyx(win, win_height, win_width);
+    if (!screen_init(&screen, win_height, win_width, config.vt_flag))
+    {
+        screen_free(&screen);
+        ncurses_kill();
+        abort();
+    }
+
     // Render loop
     while (true)
     {
-        struct sw_timestamp frame_begin;
-        sw_gettime(&frame_begin);
+        config.julian_date = start_julian_date + event_loop_elapsed(&events) * julian_rate;
 
-        werase(win);
+        WINDOW *canvas = screen_begin_frame(&screen);
 
-        if (perform_resize)
+        // Update object positions
+        const struct frame_positions *frame;
+        if (config.pipeline_flag)
         {
-            // Putting this after erasing the window reduces flickering
-            handle_resize(win);
+            frame = frame_pipeline_acquire(&pipeline);
+        }
+        else
+        {
+            update_frame_positions(&positions, &star_soa, &sky_index, pool, &ephemeris, &moon_object, config.latitude,
+                                   config.longitude, config.pm_interval, config.julian_date);
+            frame = &positions;
         }
 
-        // Update object positions
-        update_star_positions(star_table, num_stars, config.julian_date, config.latitude, config.longitude);
-        update_planet_positions(planet_table, config.julian_date, config.latitude, config.longitude);
-        update_moon_position(&moon_object, config.julian_date, config.latitude, config.longitude);
-        update_moon_phase(&moon_object, config.julian_date, config.latitude);
+        apply_frame_positions(frame, star_table, &star_soa, &sky_index, planet_table, &moon_object);
+        update_moon_phase(&moon_object, frame->julian_date, config.latitude);
+
+        if (config.pipeline_flag)
+        {
+            // The positions have been copied out, so the compute thread can
+            // start on the frame after next while this one is rendered,
+            // assuming the frame interval stays the same
+            double ahead = event_loop_elapsed(&events) + 2.0 * frame_interval / 1.0E6;
+            frame_pipeline_release(&pipeline, start_julian_date + ahead * julian_rate);
+        }
 
         // Render
-        render_stars_stereo(win, &config, star_table, num_stars, num_by_mag);
+        render_stars_stereo(canvas, &config, star_table, num_visible, visible_by_mag);
         if (config.constell_flag != 0)
         {
-            render_constells(win, &config, &constell_table, num_const, star_table);
+            render_constells(canvas, &config, &constell_table, num_const, star_table);
         }
-        render_planets_stereo(win, &config, planet_table);
-        render_moon_stereo(win, &config, moon_object);
+        render_planets_stereo(canvas, &config, planet_table);
+        render_moon_stereo(canvas, &config, moon_object);
         if (config.grid_flag != 0)
         {
-            render_azimuthal_grid(win, &config);
+            render_azimuthal_grid(canvas, &config);
         }
         else
         {
-            render_cardinal_directions(win, &config);
+            render_cardinal_directions(canvas, &config);
         }
 
-        // Exit if ESC or q is pressed
-        int ch = wgetch(win);
-        if (ch == 27 || ch == 'q')
+        // Send the frame to the terminal, measuring how much was sent and how
+        // long it took. Curses output can't be counted, so it is estimated
+        struct sw_timestamp present_begin;
+        sw_gettime(&present_begin);
+
+        size_t bytes;
+        if (config.vt_flag)
         {
-            // Note: wgetch also calls wrefresh(win), so we want this at the
-            // bottom after the virtual screen is updated
-            break;
+            bytes = screen_present_vt(&screen, win, STDOUT_FILENO);
+        }
+        else
+        {
+            bytes = screen_present(&screen, win) * SCREEN_CURSES_BYTES_PER_CELL;
+            wrefresh(win);
         }
 
-        // TODO: this timing scheme *should* minimize any drift or divergence
-        // between simulation time and realtime. Check this to make sure.
+        struct sw_timestamp present_end;
+        sw_gettime(&present_end);
 
-        // Increment "simulation" time
-        const double microsec_per_day = 24.0 * 60.0 * 60.0 * 1.0E6;
-        config.julian_date += (double)dt / microsec_per_day * config.animation_mult;
+        unsigned long long present_time;
+        sw_timediff_usec(present_end, present_begin, &present_time);
 
-        // Determine time it took to update positions and render to screen
-        struct sw_timestamp frame_end;
-        sw_gettime(&frame_end);
+        if (config.max_bandwidth > 0.0 || config.skip_idle_flag)
+        {
+            frame_interval = dt;
+
+            if (config.max_bandwidth > 0.0)
+            {
+                frame_interval = (unsigned long)(frame_limiter_update(&limiter, bytes, present_time / 1.0E6) * 1.0E6);
+            }
+
+            if (config.skip_idle_flag)
+            {
+                // Wait until something could have moved half a cell, which is
+                // as far as rounding to cells already displaces objects
+                double idle_days = render_stereo_days_per_cells(win, 0.5);
+                double idle_interval = fabs(config.animation_mult) > 0.0
+                                           ? idle_days / fabs(config.animation_mult) * microsec_per_day
+                                           : max_idle_interval;
+                if (idle_interval > max_idle_interval)
+                {
+                    idle_interval = max_idle_interval;
+                }
+                if (idle_interval > frame_interval)
+                {
+                    frame_interval = (unsigned long)idle_interval;
+                }
+            }
+        }
 
-        unsigned long long frame_time;
-        sw_timediff_usec(frame_end, frame_begin, &frame_time);
+        // Wait for the next frame, handling keys as they arrive. A resize is
+        // redrawn right away, in place of the frame that was due. With VT
+        // output, input is read through the canvas pad, since wgetch does not
+        // refresh pads
+        WINDOW *input_win = config.vt_flag ? canvas : win;
+        event_loop_schedule(&events, frame_interval);
 
-        if (frame_time < dt)
+        bool quit = false;
+        enum event_type event;
+        do
+        {
+            event = event_loop_wait(&events);
+            if (event == EVENT_INPUT)
+            {
+                quit = handle_input(input_win);
+            }
+            else if (event == EVENT_RESIZE)
+            {
+                handle_resize(win, &screen);
+            }
+        } while (event == EVENT_INPUT && !quit);
+
+        if (quit)
         {
-            sw_sleep(dt - frame_time);
+            break;
         }
     }
 
+    screen_free(&screen);
     ncurses_kill();
 
-    free_constells(constell_table, num_const);
-    free_stars(star_table, num_stars);
-    free_planets(planet_table, NUM_PLANETS);
+    if (config.pipeline_flag)
+    {
+        frame_pipeline_stop(&pipeline);
+    }
+    else
+    {
+        free_frame_positions(&positions);
+    }
+
+    if (pool != NULL)
+    {
+        thread_pool_destroy(pool);
+    }
+
     free_moon_object(moon_object);
+    event_loop_free(&events);
+
+    if (config.alloc_stats_flag)
+    {
+        arena_print_stats(&startup_arena, "Startup arena");
+    }
+    arena_destroy(&startup_arena);
 
     return 0;
 }
@@ -190,6 +424,30 @@ void parse_options(int argc, char *argv[], struct conf *config)
         arg_dbl0("l", "label-thresh", "<float>", "Label stars brighter than this magnitude (default: 0.5)");
     struct arg_int *fps_arg = arg_int0("f", "fps", "<int>", "Frames per second (default: 24)");
     struct arg_dbl *anim_arg = arg_dbl0("s", "speed", "<float>", "Animation speed multiplier (default: 1.0)");
+    struct arg_dbl *pm_interval_arg = arg_dbl0(NULL, "pm-interval", "<days>",
+                                               "Simulated days between star proper motion updates (default: 1.0)");
+    struct arg_int *threads_arg = arg_int0(NULL, "threads", "<int>", "Worker threads for position updates (default: 1)");
+    struct arg_str *catalog_arg =
+        arg_str0(NULL, "catalog", "<file>", "Load stars from a catalog file in the BSC5 binary format");
+    struct arg_lit *pipeline_arg =
+        arg_lit0(NULL, "pipeline", "Compute the next frame's positions on a separate thread while rendering");
+    struct arg_lit *vt_arg = arg_lit0(NULL, "vt", "Write frames to the terminal with VT escape sequences, bypassing "
+                                                  "ncurses output");
+    struct arg_dbl *bandwidth_arg =
+        arg_dbl0(NULL, "max-bandwidth", "<bytes/s>",
+                 "Lower the frame rate as needed to keep terminal output under this rate (default: unlimited)");
+    struct arg_lit *skip_idle_arg =
+        arg_lit0(NULL, "skip-idle", "Skip frames in which nothing could have visibly moved");
+    struct arg_str *export_arg =
+        arg_str0(NULL, "export", "<file>", "Write positions to a file, or - for stdout, instead of drawing them");
+    struct arg_str *export_end_arg =
+        arg_str0(NULL, "export-end", "<yyyy-mm-ddThh:mm:ss>", "Last datetime to export in UTC (default: --datetime)");
+    struct arg_dbl *export_step_arg =
+        arg_dbl0(NULL, "export-step", "<minutes>", "Simulated minutes between exported datetimes (default: 60)");
+    struct arg_str *export_format_arg =
+        arg_str0(NULL, "export-format", "<csv|binary>", "Format of exported positions (default: csv)");
+    struct arg_lit *alloc_stats_arg =
+        arg_lit0(NULL, "alloc-stats", "Print startup memory allocation statistics on exit");
     struct arg_lit *color_arg = arg_lit0(NULL, "color", "Enable terminal colors");
     struct arg_lit *constell_arg = arg_lit0(NULL, "constellations",
                                             "Draw constellations stick figures. Note: a constellation is only "
@@ -200,8 +458,11 @@ void parse_options(int argc, char *argv[], struct conf *config)
     struct arg_end *end = arg_end(20);
 
     // Create argtable array
-    void *argtable[] = {latitude_arg, longitude_arg, datetime_arg, threshold_arg, label_arg, fps_arg, anim_arg,
-                        color_arg,    constell_arg,  grid_arg,     ascii_arg,     help_arg,  end};
+    void *argtable[] = {latitude_arg,   longitude_arg,   datetime_arg,      threshold_arg,   label_arg,
+                        fps_arg,        anim_arg,        pm_interval_arg,   threads_arg,     pipeline_arg,
+                        catalog_arg,    vt_arg,          bandwidth_arg,     skip_idle_arg,   export_arg,
+                        export_end_arg, export_step_arg, export_format_arg, alloc_stats_arg, color_arg,
+                        constell_arg,   grid_arg,        ascii_arg,         help_arg,        end};
 
     // Parse the arguments
     int nerrors = arg_parse(argc, argv, argtable);
@@ -272,6 +533,94 @@ void parse_options(int argc, char *argv[], struct conf *config)
         config->animation_mult = (float)anim_arg->dval[0];
     }
 
+    if (pm_interval_arg->count > 0)
+    {
+        config->pm_interval = pm_interval_arg->dval[0];
+        if (config->pm_interval < 0)
+        {
+            fprintf(stderr, "ERROR: Proper motion interval must be non-negative\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (threads_arg->count > 0)
+    {
+        config->threads = threads_arg->ival[0];
+        if (config->threads < 1)
+        {
+            fprintf(stderr, "ERROR: Threads must be greater than or equal to 1\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (pipeline_arg->count > 0)
+    {
+        config->pipeline_flag = TRUE;
+    }
+
+    if (catalog_arg->count > 0)
+    {
+        config->catalog_path = catalog_arg->sval[0];
+    }
+
+    if (alloc_stats_arg->count > 0)
+    {
+        config->alloc_stats_flag = TRUE;
+    }
+
+    if (vt_arg->count > 0)
+    {
+        config->vt_flag = TRUE;
+    }
+
+    if (skip_idle_arg->count > 0)
+    {
+        config->skip_idle_flag = TRUE;
+    }
+
+    if (bandwidth_arg->count > 0)
+    {
+        config->max_bandwidth = bandwidth_arg->dval[0];
+        if (config->max_bandwidth <= 0)
+        {
+            fprintf(stderr, "ERROR: Maximum bandwidth must be positive\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (export_arg->count > 0)
+    {
+        config->export_path = export_arg->sval[0];
+    }
+
+    if (export_end_arg->count > 0)
+    {
+        config->export_end_string_utc = export_end_arg->sval[0];
+    }
+
+    if (export_step_arg->count > 0)
+    {
+        if (export_step_arg->dval[0] <= 0)
+        {
+            fprintf(stderr, "ERROR: Export step must be positive\n");
+            exit(EXIT_FAILURE);
+        }
+        config->export_step = export_step_arg->dval[0] / (24.0 * 60.0);
+    }
+
+    if (export_format_arg->count > 0)
+    {
+        if (strcmp(export_format_arg->sval[0], "binary") == 0)
+        {
+            config->export_binary_flag = TRUE;
+        }
+        else if (strcmp(export_format_arg->sval[0], "csv") != 0)
+        {
+            fprintf(stderr, "ERROR: Export format must be csv or binary\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     if (color_arg->count > 0)
     {
         config->color_flag = TRUE;
@@ -326,15 +675,103 @@ void convert_options(struct conf *config)
         config->julian_date = datetime_to_julian_date(&datetime);
     }
 
+    // Exports cover a single datetime unless an end is given
+    config->export_end_julian_date = config->julian_date;
+    if (config->export_end_string_utc != NULL)
+    {
+        struct tm datetime;
+        if (!string_to_time(config->export_end_string_utc, &datetime))
+        {
+            fprintf(stderr,
+                    "ERROR: Unable to parse datetime string '%s'\nDatetimes "
+                    "must be in form <yyyy-mm-ddThh:mm:ss>\n",
+                    config->export_end_string_utc);
+            exit(EXIT_FAILURE);
+        }
+        config->export_end_julian_date = datetime_to_julian_date(&datetime);
+        if (config->export_end_julian_date < config->julian_date)
+        {
+            fprintf(stderr, "ERROR: Export end must not be before the start datetime\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     return;
 }
 
-void catch_winch(int sig)
+int run_export(const struct conf *config, struct star_soa *star_soa, const struct star *star_table,
+               const struct planet *planet_table, const struct moon *moon_object)
+{
+    int fd = STDOUT_FILENO;
+    if (strcmp(config->export_path, "-") != 0)
+    {
+        fd = open(config->export_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            fprintf(stderr, "ERROR: Unable to open '%s' for export\n", config->export_path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct thread_pool worker_pool;
+    struct thread_pool *pool = NULL;
+    if (config->threads > 1)
+    {
+        if (!thread_pool_init(&worker_pool, (unsigned int)config->threads))
+        {
+            abort();
+        }
+        pool = &worker_pool;
+    }
+
+    // Both ends of the range are included. The small tolerance keeps the end
+    // when the range is a whole number of steps
+    unsigned long num_dates =
+        (unsigned long)floor((config->export_end_julian_date - config->julian_date) / config->export_step + 1.0E-9) + 1;
+
+    struct export_writer writer;
+    bool s = export_writer_init(&writer, fd, config->export_binary_flag ? EXPORT_BINARY : EXPORT_CSV);
+    s = s && export_positions(&writer, star_soa, star_table, planet_table, moon_object, pool, config->latitude,
+                              config->longitude, config->pm_interval, config->julian_date, config->export_step,
+                              num_dates);
+    export_writer_free(&writer);
+
+    if (pool != NULL)
+    {
+        thread_pool_destroy(pool);
+    }
+
+    if (fd != STDOUT_FILENO && close(fd) != 0)
+    {
+        s = false;
+    }
+
+    if (!s)
+    {
+        fprintf(stderr, "ERROR: Export to '%s' failed\n", config->export_path);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+bool handle_input(WINDOW *input_win)
 {
-    perform_resize = true;
+    // Read every pending key. Exit if ESC or q is pressed
+    wtimeout(input_win, 0);
+    int ch;
+    while ((ch = wgetch(input_win)) != ERR)
+    {
+        if (ch == 27 || ch == 'q')
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
-void handle_resize(WINDOW *win)
+void handle_resize(WINDOW *win, struct screen *screen)
 {
     // Resize ncurses internal terminal
     int y;
@@ -353,5 +790,12 @@ void handle_resize(WINDOW *win)
     win_resize_square(win, aspect);
     win_position_center(win);
 
-    perform_resize = false;
+    // The window was cleared, so the next frame is presented in full
+    int height, width;
+    getmaxyx(win, height, width);
+    if (!screen_resize(screen, height, width))
+    {
+        ncurses_kill();
+        abort();
+    }
 }
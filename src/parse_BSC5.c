@@ -2,16 +2,20 @@
 
 #include "bit.h"
 
+#include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 static const size_t header_bytes = 28;
 static const size_t entry_bytes = 32;
 
-static struct header parse_header(uint8_t *buffer)
+static struct header parse_header(const uint8_t *buffer)
 {
     struct header header_data;
 
@@ -19,14 +23,14 @@ static struct header parse_header(uint8_t *buffer)
     header_data.STAR1 = (int)bytes_to_int32_LE(&buffer[4]);
     header_data.STARN = (int)bytes_to_int32_LE(&buffer[8]);
     header_data.STNUM = (int)bytes_to_int32_LE(&buffer[12]);
-    header_data.MPROP = bytes_to_bool32_LE(&buffer[16]);
+    header_data.MPROP = (int)bytes_to_int32_LE(&buffer[16]);
     header_data.NMAG = (int)bytes_to_int32_LE(&buffer[20]);
     header_data.NBENT = (int)bytes_to_int32_LE(&buffer[24]);
 
     return header_data;
 }
 
-static struct entry parse_entry(uint8_t *buffer)
+static struct entry parse_entry(const uint8_t *buffer)
 {
     struct entry entry_data;
 
@@ -42,58 +46,117 @@ static struct entry parse_entry(uint8_t *buffer)
     return entry_data;
 }
 
-bool parse_entries(uint8_t *data, size_t data_size, struct entry **entries_out, unsigned int *num_entries_out)
+bool bsc5_view_init(struct bsc5_view *view, const uint8_t *data, size_t data_size)
 {
-    size_t stream_items; // Number of bytes read from data
+    view->records = NULL;
+    view->num_entries = 0;
+    view->mapping = NULL;
+    view->mapping_size = 0;
 
     // Check if there's enough data to read the header
     if (data_size < header_bytes)
     {
-        printf("Insufficient data size for header\n");
+        fprintf(stderr, "Insufficient data size for header\n");
         return false;
     }
 
-    // Read the header from the embedded binary data
-    uint8_t header_buffer[header_bytes];
-    memcpy(header_buffer, data, header_bytes);
-    struct header header_data = parse_header(header_buffer);
+    struct header header_data = parse_header(data);
 
-    // STARN is negative if coordinates are J2000 (which they are in BSC5)
+    // Entries are only decoded with the BSC5 layout, so reject any other
     // http://tdc-www.harvard.edu/catalogs/catalogsb.html
-    unsigned int num_entries = (unsigned int)abs(header_data.STARN);
+    if (header_data.NBENT != (int)entry_bytes || header_data.STNUM != 1 || header_data.MPROP != 1 ||
+        header_data.NMAG != 1)
+    {
+        fprintf(stderr, "Unsupported catalog layout (STNUM %d, MPROP %d, NMAG %d, NBENT %d)\n", header_data.STNUM,
+                header_data.MPROP, header_data.NMAG, header_data.NBENT);
+        return false;
+    }
+
+    // STARN is negative if coordinates are J2000 (which they are in BSC5) and
+    // positive if they are B1950, which are not supported
+    if (header_data.STARN >= 0 || header_data.STARN == INT_MIN)
+    {
+        fprintf(stderr, "Unsupported catalog star count %d, only J2000 catalogs can be read\n", header_data.STARN);
+        return false;
+    }
+    unsigned int num_entries = (unsigned int)-header_data.STARN;
+
+    // Check all entries up front so they can be decoded later without checks
+    if ((data_size - header_bytes) / entry_bytes < num_entries)
+    {
+        fprintf(stderr, "Insufficient data size for %u entries\n", num_entries);
+        return false;
+    }
+
+    view->records = data + header_bytes;
+    view->num_entries = num_entries;
+
+    return true;
+}
+
+struct entry bsc5_view_entry(const struct bsc5_view *view, unsigned int i)
+{
+    return parse_entry(&view->records[i * entry_bytes]);
+}
+
+float bsc5_view_magnitude(const struct bsc5_view *view, unsigned int i)
+{
+    return (float)bytes_to_int16_LE(&view->records[i * entry_bytes + 22]) / 100.0f;
+}
+
+bool bsc5_view_map(struct bsc5_view *view, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Failed to open catalog %s\n", path);
+        return false;
+    }
 
-    // Allocate memory for the entries
-    *entries_out = malloc(num_entries * sizeof(struct entry));
-    if (*entries_out == NULL)
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size == 0)
     {
-        printf("Allocation of memory for BSC5 entries failed\n");
+        fprintf(stderr, "Failed to read size of catalog %s\n", path);
+        close(fd);
         return false;
     }
 
-    // Move the data pointer to the beginning of the entries section
-    data += header_bytes;
-    data_size -= header_bytes;
+    size_t size = (size_t)file_stat.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
 
-    // Read entries from the embedded binary data
-    uint8_t entry_buffer[entry_bytes];
-    for (unsigned int i = 0; i < num_entries; ++i)
+    if (mapping == MAP_FAILED)
     {
-        if (data_size < entry_bytes)
-        {
-            printf("Insufficient data size for entry %u\n", i);
-            return false;
-        }
-
-        memcpy(entry_buffer, data, entry_bytes);
-        (*entries_out)[i] = parse_entry(entry_buffer);
-
-        // Move the data pointer to the next entry
-        data += entry_bytes;
-        data_size -= entry_bytes;
+        fprintf(stderr, "Failed to map catalog %s\n", path);
+        return false;
     }
 
-    // Set the number of entries found
-    *num_entries_out = num_entries;
+    // Records are read front to back, so let the kernel read ahead
+    posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+    if (!bsc5_view_init(view, mapping, size))
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    view->mapping = mapping;
+    view->mapping_size = size;
 
     return true;
 }
+
+void bsc5_view_unmap(struct bsc5_view *view)
+{
+    if (view->mapping != NULL)
+    {
+        munmap(view->mapping, view->mapping_size);
+    }
+    view->records = NULL;
+    view->num_entries = 0;
+    view->mapping = NULL;
+    view->mapping_size = 0;
+    return;
+}
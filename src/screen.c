@@ -0,0 +1,351 @@
+#include "screen.h"
+
+#include <errno.h>
+#include <ncurses.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#if CCHARW_MAX >= SCREEN_GLYPH_LENGTH
+#error "SCREEN_GLYPH_LENGTH is too small for this curses implementation"
+#endif
+
+// Upper bound on the bytes needed to position the cursor and set the colors of
+// one cell, e.g. "\033[9999;9999H" and "\033[0;1;2;4;7;39m"
+#define VT_CELL_OVERHEAD 32
+
+bool screen_init(struct screen *screen, int height, int width, bool vt)
+{
+    screen->canvas = NULL;
+    screen->cells = NULL;
+    screen->vt = vt;
+    screen->output = NULL;
+    screen->output_capacity = 0;
+    return screen_resize(screen, height, width);
+}
+
+bool screen_resize(struct screen *screen, int height, int width)
+{
+    height = height > 0 ? height : 1;
+    width = width > 0 ? width : 1;
+
+    if (screen->canvas == NULL)
+    {
+        screen->canvas = newpad(height, width);
+    }
+    else if (wresize(screen->canvas, height, width) == ERR)
+    {
+        delwin(screen->canvas);
+        screen->canvas = newpad(height, width);
+    }
+
+    size_t num_cells = (size_t)height * width;
+
+    free(screen->cells);
+    screen->cells = malloc(num_cells * sizeof(struct screen_cell));
+
+    bool output_failed = false;
+    if (screen->vt)
+    {
+        // Sized for the worst case so a frame never has to be split or grown
+        free(screen->output);
+        screen->output_capacity = num_cells * (VT_CELL_OVERHEAD + SCREEN_GLYPH_LENGTH * MB_CUR_MAX) + VT_CELL_OVERHEAD;
+        screen->output = malloc(screen->output_capacity);
+        output_failed = screen->output == NULL;
+    }
+
+    if (screen->canvas == NULL || screen->cells == NULL || output_failed)
+    {
+        printf("Allocation of memory for screen failed\n");
+        return false;
+    }
+
+    screen->height = height;
+    screen->width = width;
+    screen->valid = false;
+
+    return true;
+}
+
+WINDOW *screen_begin_frame(struct screen *screen)
+{
+    // Erasing the pad only touches memory, nothing is sent to the terminal
+    werase(screen->canvas);
+    return screen->canvas;
+}
+
+/* Decode a curses cell into its glyph and color
+ */
+static void decode_cell(const cchar_t *raw, struct screen_cell *cell)
+{
+    getcchar(raw, cell->glyph, &cell->attrs, &cell->color_pair, NULL);
+    cell->continuation = false;
+}
+
+static bool cells_equal(const struct screen_cell *a, const struct screen_cell *b)
+{
+    return a->continuation == b->continuation && a->attrs == b->attrs && a->color_pair == b->color_pair &&
+           wcscmp(a->glyph, b->glyph) == 0;
+}
+
+/* Call `emit` for every cell of the canvas that changed since the last
+ * presented frame, or for every cell if there is no such frame, and record the
+ * canvas as presented
+ */
+static unsigned int diff_frame(struct screen *screen,
+                               void (*emit)(void *context, int y, int x, const cchar_t *raw,
+                                            const struct screen_cell *cell),
+                               void *context)
+{
+    unsigned int num_changed = 0;
+
+    for (int y = 0; y < screen->height; ++y)
+    {
+        struct screen_cell *row = &screen->cells[y * screen->width];
+
+        for (int x = 0; x < screen->width; ++x)
+        {
+            cchar_t raw;
+            struct screen_cell cell;
+            mvwin_wch(screen->canvas, y, x, &raw);
+            decode_cell(&raw, &cell);
+
+            // A double width glyph also covers the next cell, which is
+            // written along with it and must not be written on its own. That
+            // cell is recorded as a continuation, which never matches a
+            // decoded cell, so whatever is drawn there next is written. The
+            // glyph itself is written again if the cell it covers held
+            // anything else, since writing that may have cut it in half
+            bool wide = wcwidth(cell.glyph[0]) == 2 && x + 1 < screen->width;
+
+            if (!screen->valid || !cells_equal(&cell, &row[x]) || (wide && !row[x + 1].continuation))
+            {
+                emit(context, y, x, &raw, &cell);
+                row[x] = cell;
+                ++num_changed;
+            }
+
+            if (wide)
+            {
+                row[x + 1] = (struct screen_cell){.continuation = true};
+                ++x;
+            }
+        }
+    }
+
+    screen->valid = true;
+
+    return num_changed;
+}
+
+// Curses output
+
+static void emit_curses(void *context, int y, int x, const cchar_t *raw, const struct screen_cell *cell)
+{
+    WINDOW *win = context;
+    mvwadd_wch(win, y, x, raw);
+}
+
+unsigned int screen_present(struct screen *screen, WINDOW *win)
+{
+    return diff_frame(screen, emit_curses, win);
+}
+
+// VT output
+
+struct vt_state
+{
+    char *output;
+    size_t length;
+    int origin_y; // Terminal position of the canvas' top left cell
+    int origin_x;
+    int cursor_y; // Canvas position of the cursor, -1 if unknown
+    int cursor_x;
+    attr_t attrs;
+    short color_pair;
+    mbstate_t shift_state;
+};
+
+static void vt_append(struct vt_state *vt, const char *bytes, size_t length)
+{
+    memcpy(vt->output + vt->length, bytes, length);
+    vt->length += length;
+}
+
+static void vt_move(struct vt_state *vt, int y, int x)
+{
+    if (y == vt->cursor_y && x == vt->cursor_x)
+    {
+        return;
+    }
+
+    char sequence[VT_CELL_OVERHEAD];
+    int length;
+    if (y == vt->cursor_y && x > vt->cursor_x)
+    {
+        // Cursor forward is shorter than an absolute position
+        length = x - vt->cursor_x == 1 ? snprintf(sequence, sizeof(sequence), "\033[C")
+                                       : snprintf(sequence, sizeof(sequence), "\033[%dC", x - vt->cursor_x);
+    }
+    else
+    {
+        length = snprintf(sequence, sizeof(sequence), "\033[%d;%dH", vt->origin_y + y + 1, vt->origin_x + x + 1);
+    }
+    vt_append(vt, sequence, (size_t)length);
+
+    vt->cursor_y = y;
+    vt->cursor_x = x;
+}
+
+static void vt_set_color(struct vt_state *vt, attr_t attrs, short color_pair)
+{
+    if (attrs == vt->attrs && color_pair == vt->color_pair)
+    {
+        return;
+    }
+
+    char sequence[VT_CELL_OVERHEAD];
+    int length = snprintf(sequence, sizeof(sequence), "\033[0");
+
+    if (attrs & A_BOLD)
+    {
+        length += snprintf(sequence + length, sizeof(sequence) - length, ";1");
+    }
+    if (attrs & A_DIM)
+    {
+        length += snprintf(sequence + length, sizeof(sequence) - length, ";2");
+    }
+    if (attrs & A_UNDERLINE)
+    {
+        length += snprintf(sequence + length, sizeof(sequence) - length, ";4");
+    }
+    if (attrs & A_REVERSE)
+    {
+        length += snprintf(sequence + length, sizeof(sequence) - length, ";7");
+    }
+
+    // Pairs set up in ncurses_init only have a foreground color
+    short foreground, background;
+    if (color_pair != 0 && pair_content(color_pair, &foreground, &background) != ERR && 0 <= foreground &&
+        foreground < 8)
+    {
+        length += snprintf(sequence + length, sizeof(sequence) - length, ";%d", 30 + foreground);
+    }
+
+    length += snprintf(sequence + length, sizeof(sequence) - length, "m");
+    vt_append(vt, sequence, (size_t)length);
+
+    vt->attrs = attrs;
+    vt->color_pair = color_pair;
+}
+
+static void emit_vt(void *context, int y, int x, const cchar_t *raw, const struct screen_cell *cell)
+{
+    struct vt_state *vt = context;
+
+    vt_move(vt, y, x);
+    vt_set_color(vt, cell->attrs, cell->color_pair);
+
+    for (const wchar_t *wc = cell->glyph; *wc != L'\0'; ++wc)
+    {
+        size_t length = wcrtomb(vt->output + vt->length, *wc, &vt->shift_state);
+        if (length == (size_t)-1)
+        {
+            // Not representable in the current locale
+            memset(&vt->shift_state, 0, sizeof(vt->shift_state));
+            vt_append(vt, "?", 1);
+            continue;
+        }
+        vt->length += length;
+    }
+
+    // Terminals disagree on the width of wide and combined glyphs, so the
+    // cursor position is only trusted after plain single width ones
+    int width = wcwidth(cell->glyph[0]);
+    if (width == 1 && cell->glyph[1] == L'\0')
+    {
+        vt->cursor_x = x + 1;
+    }
+    else
+    {
+        vt->cursor_y = -1;
+        vt->cursor_x = -1;
+    }
+}
+
+size_t screen_present_vt(struct screen *screen, WINDOW *win, int fd)
+{
+    struct vt_state vt = {
+        .output = screen->output,
+        .length = 0,
+        .cursor_y = -1,
+        .cursor_x = -1,
+        .attrs = A_NORMAL,
+        .color_pair = 0,
+    };
+    memset(&vt.shift_state, 0, sizeof(vt.shift_state));
+    getbegyx(win, vt.origin_y, vt.origin_x);
+
+    // Every frame leaves the default colors set, so only a full redraw has to
+    // reset them, along with blanking the terminal
+    if (!screen->valid)
+    {
+        vt_append(&vt, "\033[0m\033[2J", 8);
+    }
+
+    diff_frame(screen, emit_vt, &vt);
+
+    if (vt.attrs != A_NORMAL || vt.color_pair != 0)
+    {
+        vt_append(&vt, "\033[0m", 4);
+    }
+
+    // The whole frame goes out in one write unless the terminal applies
+    // backpressure and accepts only part of it
+    size_t written = 0;
+    while (written < vt.length)
+    {
+        ssize_t result = write(fd, vt.output + written, vt.length - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // Non-blocking output is full, so sleep until it drains
+                struct pollfd output = {.fd = fd, .events = POLLOUT};
+                if (poll(&output, 1, -1) >= 0 || errno == EINTR)
+                {
+                    continue;
+                }
+            }
+
+            // The terminal is gone or unusable, so redraw fully if it recovers
+            screen->valid = false;
+            break;
+        }
+        written += (size_t)result;
+    }
+
+    return written;
+}
+
+void screen_free(struct screen *screen)
+{
+    if (screen->canvas != NULL)
+    {
+        delwin(screen->canvas);
+    }
+    free(screen->cells);
+    free(screen->output);
+    screen->canvas = NULL;
+    screen->cells = NULL;
+    screen->output = NULL;
+}
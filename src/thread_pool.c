@@ -0,0 +1,170 @@
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Chunks handed out per thread for each job. More chunks than threads keeps
+// threads busy when the work per index is uneven
+#define CHUNKS_PER_THREAD 4
+
+/* Claim and run chunks of the current job until none are left. Must be called
+ * with the pool mutex held, and returns with it held
+ */
+static void run_chunks(struct thread_pool *pool)
+{
+    while (pool->next < pool->count)
+    {
+        unsigned int begin = pool->next;
+        unsigned int end = begin + pool->chunk_size;
+        if (end > pool->count)
+        {
+            end = pool->count;
+        }
+        pool->next = end;
+
+        void (*task)(void *, unsigned int, unsigned int) = pool->task;
+        void *arg = pool->arg;
+
+        pthread_mutex_unlock(&pool->mutex);
+        task(arg, begin, end);
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->pending--;
+        if (pool->pending == 0)
+        {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+}
+
+static void *worker_main(void *data)
+{
+    struct thread_pool *pool = data;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    unsigned long seen = pool->generation;
+    while (true)
+    {
+        while (pool->generation == seen && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->work_ready, &pool->mutex);
+        }
+
+        if (pool->shutdown)
+        {
+            break;
+        }
+
+        seen = pool->generation;
+        run_chunks(pool);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+bool thread_pool_init(struct thread_pool *pool, unsigned int num_threads)
+{
+    if (num_threads < 1)
+    {
+        num_threads = 1;
+    }
+
+    pool->num_threads = num_threads;
+    pool->task = NULL;
+    pool->arg = NULL;
+    pool->count = 0;
+    pool->chunk_size = 0;
+    pool->next = 0;
+    pool->pending = 0;
+    pool->generation = 0;
+    pool->shutdown = false;
+
+    // One extra byte so a single threaded pool never requests zero bytes
+    pool->threads = malloc((num_threads - 1) * sizeof(pthread_t) + 1);
+    if (pool->threads == NULL)
+    {
+        printf("Allocation of memory for thread pool failed\n");
+        return false;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (unsigned int i = 0; i < num_threads - 1; ++i)
+    {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0)
+        {
+            printf("Creation of worker thread failed\n");
+            pool->num_threads = i + 1;
+            thread_pool_destroy(pool);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void thread_pool_run(struct thread_pool *pool, void (*task)(void *arg, unsigned int begin, unsigned int end), void *arg,
+                     unsigned int count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (pool == NULL || pool->num_threads == 1)
+    {
+        task(arg, 0, count);
+        return;
+    }
+
+    unsigned int num_chunks = pool->num_threads * CHUNKS_PER_THREAD;
+    unsigned int chunk_size = (count + num_chunks - 1) / num_chunks;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->task = task;
+    pool->arg = arg;
+    pool->count = count;
+    pool->chunk_size = chunk_size;
+    pool->next = 0;
+    pool->pending = (count + chunk_size - 1) / chunk_size;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+
+    // Help out, then wait for the chunks claimed by workers
+    run_chunks(pool);
+    while (pool->pending > 0)
+    {
+        pthread_cond_wait(&pool->work_done, &pool->mutex);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void thread_pool_destroy(struct thread_pool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (unsigned int i = 0; i < pool->num_threads - 1; ++i)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->num_threads = 0;
+}
@@ -0,0 +1,56 @@
+#include "arena.h"
+#include "unity.h"
+
+#include <stdint.h>
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+}
+
+void test_alloc_is_aligned(void)
+{
+    struct arena arena;
+    arena_init(&arena, 256);
+
+    for (size_t size = 1; size < 40; ++size)
+    {
+        void *memory = arena_alloc(&arena, size);
+        TEST_ASSERT_NOT_NULL(memory);
+        TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)memory % 16);
+    }
+
+    arena_destroy(&arena);
+}
+
+void test_stats_count_allocations_and_blocks(void)
+{
+    struct arena arena;
+    arena_init(&arena, 256);
+
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100)); // Rounded up to 112
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100)); // Same block
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100)); // New block
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 1000)); // Oversized block of its own
+
+    TEST_ASSERT_EQUAL_UINT(4, arena.num_allocations);
+    TEST_ASSERT_EQUAL_UINT(3, arena.num_blocks);
+    TEST_ASSERT_EQUAL_UINT(3 * 112 + 1008, arena.bytes_allocated);
+    TEST_ASSERT_EQUAL_UINT(2 * 256 + 1008, arena.bytes_reserved);
+
+    arena_destroy(&arena);
+    TEST_ASSERT_EQUAL_UINT(0, arena.num_allocations);
+    TEST_ASSERT_EQUAL_UINT(0, arena.bytes_reserved);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_alloc_is_aligned);
+    RUN_TEST(test_stats_count_allocations_and_blocks);
+
+    return UNITY_END();
+}
@@ -118,10 +118,84 @@ void test_calc_moon_phase(void)
     // TEST_ASSERT_FLOAT_WITHIN(EPSILON_PHASE, 0.0, distance);
 }
 
+// -----------------------------------------------------------------------------
+// solve_kepler_batch
+// -----------------------------------------------------------------------------
+
+void test_solve_kepler_batch(void)
+{
+    // An odd count exercises both the vector lanes and the scalar remainder
+    enum
+    {
+        NUM_ORBITS = 39
+    };
+    double M[NUM_ORBITS], e[NUM_ORBITS], E[NUM_ORBITS], sin_E[NUM_ORBITS], cos_E[NUM_ORBITS];
+    for (int i = 0; i < NUM_ORBITS; ++i)
+    {
+        M[i] = -10.0 + 20.0 * i / (NUM_ORBITS - 1);
+        e[i] = 0.95 * (i % 13) / 12.0;
+    }
+
+    solve_kepler_batch(M, e, NUM_ORBITS, E, sin_E, cos_E);
+
+    for (int i = 0; i < NUM_ORBITS; ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, M[i], E[i] - e[i] * sin(E[i]));
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, sin(E[i]), sin_E[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, cos(E[i]), cos_E[i]);
+    }
+}
+
+void test_calc_planet_helio_ICRF_epochs(void)
+{
+    const struct kep_elems mars_elements = {1.52371243, 0.09336511, 1.85181869, 19.34931620, -73.63065768, 49.71320984};
+    const struct kep_rates mars_rates = {0.00000097, 0.00009149, -0.00724757, 19139.84710618, 0.72076056, -0.26852431};
+
+    double dates[100], x[100], y[100], z[100];
+    for (int i = 0; i < 100; ++i)
+    {
+        dates[i] = 2451545.0 + 7.3 * i;
+    }
+
+    calc_planet_helio_ICRF_epochs(&mars_elements, &mars_rates, NULL, dates, 100, NULL, x, y, z);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        double xs, ys, zs;
+        calc_planet_helio_ICRF(&mars_elements, &mars_rates, NULL, dates[i], &xs, &ys, &zs);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, xs, x[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, ys, y[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, zs, z[i]);
+    }
+}
+
+void test_calc_planet_helio_ICRF_epochs_cached_rotation(void)
+{
+    const struct kep_elems mars_elements = {1.52371243, 0.09336511, 1.85181869, 19.34931620, -73.63065768, 49.71320984};
+    const struct kep_rates mars_rates = {0.00000097, 0.00009149, -0.00724757, 19139.84710618, 0.72076056, -0.26852431};
+
+    // Two centuries, long enough for the orbital angles to drift past the
+    // point at which the cached rotation is re-evaluated
+    struct orbit_rotation rotation = {.valid = false};
+    for (int i = 0; i < 200; ++i)
+    {
+        double date = 2451545.0 - 36525.0 + 365.25 * i;
+        double x, y, z, xs, ys, zs;
+        calc_planet_helio_ICRF_epochs(&mars_elements, &mars_rates, NULL, &date, 1, &rotation, &x, &y, &z);
+        calc_planet_helio_ICRF(&mars_elements, &mars_rates, NULL, date, &xs, &ys, &zs);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, xs, x);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, ys, y);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-12, zs, z);
+    }
+}
+
 int main(void)
 {
     UNITY_BEGIN();
     RUN_TEST(test_datetime_to_julian_date);
     RUN_TEST(test_calc_moon_phase);
+    RUN_TEST(test_solve_kepler_batch);
+    RUN_TEST(test_calc_planet_helio_ICRF_epochs);
+    RUN_TEST(test_calc_planet_helio_ICRF_epochs_cached_rotation);
     return UNITY_END();
 }
@@ -1,6 +1,8 @@
 #include "coord.h"
 #include "unity.h"
 
+#include <math.h>
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -46,11 +48,51 @@ void test_project_stereographic_top(void)
     TEST_ASSERT_FLOAT_WITHIN(0.01, expected_theta_polar, theta_polar);
 }
 
+void test_frame_transform_matches_equatorial_to_horizontal(void)
+{
+    double gmst = 4.3;
+    double latitude = 0.74;
+    double longitude = -1.24;
+
+    struct frame_transform transform;
+    frame_transform_init(&transform, gmst, latitude, longitude);
+
+    double ra_values[3] = {0.1, 2.5, 5.9};
+    double dec_values[3] = {-1.2, 0.0, 0.9};
+
+    double x[3], y[3], z[3];
+    double batch_azimuth[3], batch_altitude[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        x[i] = cos(dec_values[i]) * cos(ra_values[i]);
+        y[i] = cos(dec_values[i]) * sin(ra_values[i]);
+        z[i] = sin(dec_values[i]);
+    }
+    frame_transform_unit_vectors(&transform, x, y, z, 3, batch_azimuth, batch_altitude);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        double expected_azimuth, expected_altitude;
+        equatorial_to_horizontal(ra_values[i], dec_values[i], gmst, latitude, longitude, &expected_azimuth,
+                                 &expected_altitude);
+
+        // Vectors passed to frame_transform_apply need not be normalized
+        double azimuth, altitude;
+        frame_transform_apply(&transform, 2.0 * x[i], 2.0 * y[i], 2.0 * z[i], &azimuth, &altitude);
+
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected_azimuth, azimuth);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected_altitude, altitude);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected_azimuth, batch_azimuth[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected_altitude, batch_altitude[i]);
+    }
+}
+
 int main(void)
 {
     UNITY_BEGIN();
 
     RUN_TEST(test_project_stereographic_top);
+    RUN_TEST(test_frame_transform_matches_equatorial_to_horizontal);
 
     return UNITY_END();
 }
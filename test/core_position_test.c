@@ -0,0 +1,67 @@
+#include "core_position.h"
+#include "unity.h"
+
+#include "arena.h"
+#include "coord.h"
+#include "core.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define J2000 2451545.0
+#define DAYS_PER_YEAR 365.2425
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+}
+
+void test_fast_star_far_from_j2000(void)
+{
+    struct arena arena;
+    arena_init(&arena, 4096);
+
+    // The fastest proper motion a packed star can hold, 5000 years after
+    // J2000, puts the linearly propagated vector well off the unit sphere
+    static const struct packed_star packed_table[1] = {
+        {0u, 268435456, INT16_MAX, INT16_MAX, 100, 0},
+    };
+    static const int star_numbers[1] = {1};
+    struct star_soa star_soa;
+    TEST_ASSERT_TRUE(generate_star_soa(&star_soa, packed_table, star_numbers, 1, &arena));
+
+    struct frame_positions positions;
+    TEST_ASSERT_TRUE(generate_frame_positions(&positions, 1, 0));
+
+    double years = 5000.0;
+    struct frame_transform transform;
+    frame_transform_init(&transform, 1.0, 0.7, -0.3);
+    update_star_positions(&positions, &star_soa, NULL, NULL, J2000 + years * DAYS_PER_YEAR, 1.0, &transform);
+
+    // frame_transform_apply accepts vectors of any length
+    double azimuth, altitude;
+    frame_transform_apply(&transform, star_soa.x[0] + star_soa.dx[0] * years, star_soa.y[0] + star_soa.dy[0] * years,
+                          star_soa.z[0] + star_soa.dz[0] * years, &azimuth, &altitude);
+
+    TEST_ASSERT_FLOAT_WITHIN(1.0E-9, azimuth, positions.star_azimuth[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1.0E-9, altitude, positions.star_altitude[0]);
+
+    // Cached vectors are unit vectors
+    double norm = sqrt(star_soa.eq_x[0] * star_soa.eq_x[0] + star_soa.eq_y[0] * star_soa.eq_y[0] +
+                       star_soa.eq_z[0] * star_soa.eq_z[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1.0E-12, 1.0, norm);
+
+    free_frame_positions(&positions);
+    arena_destroy(&arena);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fast_star_far_from_j2000);
+
+    return UNITY_END();
+}
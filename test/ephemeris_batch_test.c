@@ -0,0 +1,159 @@
+#include "ephemeris_batch.h"
+#include "unity.h"
+
+#include "astro.h"
+#include "coord.h"
+#include "core.h"
+#include "data/keplerian_elements.h"
+#include "thread_pool.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Tolerance for angles in radians
+#define EPSILON 1.0E-9
+
+// A year of dates at one hour resolution
+#define NUM_DATES 8766
+
+static struct arena arena;
+static struct planet *planet_table;
+static struct moon moon_object;
+static double dates[NUM_DATES];
+
+static const double latitude = 0.73;
+static const double longitude = -1.29;
+
+void setUp(void)
+{
+    arena_init(&arena, 4096);
+    TEST_ASSERT_TRUE(generate_planet_table(&planet_table, planet_elements, planet_rates, planet_extras, &arena));
+    TEST_ASSERT_TRUE(generate_moon_object(&moon_object, &moon_elements, &moon_rates));
+
+    for (int i = 0; i < NUM_DATES; ++i)
+    {
+        dates[i] = 2460000.5 + i / 24.0;
+    }
+}
+void tearDown(void)
+{
+    arena_destroy(&arena);
+}
+
+/* Check a body against the scalar astro functions at every date
+ */
+static void assert_matches_scalar(int body, const double *right_ascension, const double *declination,
+                                  const double *azimuth, const double *altitude)
+{
+    for (int i = 0; i < NUM_DATES; ++i)
+    {
+        double xg, yg, zg;
+        if (body == BATCH_MOON)
+        {
+            calc_moon_geo_ICRF(moon_object.elements, moon_object.rates, dates[i], NULL, &xg, &yg, &zg);
+        }
+        else
+        {
+            const struct planet *earth = &planet_table[EARTH];
+            double xe, ye, ze;
+            calc_planet_helio_ICRF(earth->elements, earth->rates, earth->extras, dates[i], &xe, &ye, &ze);
+
+            // The Sun is at the origin
+            xg = yg = zg = 0.0;
+            if (body != SUN)
+            {
+                const struct planet *planet = &planet_table[body];
+                calc_planet_helio_ICRF(planet->elements, planet->rates, planet->extras, dates[i], &xg, &yg, &zg);
+            }
+            xg -= xe;
+            yg -= ye;
+            zg -= ze;
+        }
+
+        double expected_ra, expected_dec;
+        equatorial_rectangular_to_spherical(xg, yg, zg, &expected_ra, &expected_dec);
+        if (expected_ra < 0.0)
+        {
+            expected_ra += 2.0 * M_PI;
+        }
+
+        struct frame_transform transform;
+        frame_transform_init(&transform, greenwich_mean_sidereal_time_rad(dates[i]), latitude, longitude);
+        double expected_az, expected_alt;
+        frame_transform_apply(&transform, xg, yg, zg, &expected_az, &expected_alt);
+
+        TEST_ASSERT_FLOAT_WITHIN(EPSILON, expected_ra, right_ascension[i]);
+        TEST_ASSERT_FLOAT_WITHIN(EPSILON, expected_dec, declination[i]);
+        TEST_ASSERT_FLOAT_WITHIN(EPSILON, expected_az, azimuth[i]);
+        TEST_ASSERT_FLOAT_WITHIN(EPSILON, expected_alt, altitude[i]);
+    }
+}
+
+static double right_ascension[BATCH_NUM_BODIES * NUM_DATES];
+static double declination[BATCH_NUM_BODIES * NUM_DATES];
+static double azimuth[BATCH_NUM_BODIES * NUM_DATES];
+static double altitude[BATCH_NUM_BODIES * NUM_DATES];
+
+static void check_batch(unsigned int body_set, struct thread_pool *pool)
+{
+    struct batch_positions output = {
+        .right_ascension = right_ascension,
+        .declination = declination,
+        .azimuth = azimuth,
+        .altitude = altitude,
+    };
+    ephemeris_batch_compute(planet_table, &moon_object, body_set, dates, NUM_DATES, latitude, longitude, pool,
+                            &output);
+
+    // Bodies are laid out one after the other, in body order
+    unsigned int offset = 0;
+    for (int body = 0; body < BATCH_NUM_BODIES; ++body)
+    {
+        if (body_set & BATCH_BODY(body))
+        {
+            assert_matches_scalar(body, &right_ascension[offset], &declination[offset], &azimuth[offset],
+                                  &altitude[offset]);
+            offset += NUM_DATES;
+        }
+    }
+}
+
+void test_batch_num_bodies(void)
+{
+    TEST_ASSERT_EQUAL_UINT(0, batch_num_bodies(0));
+    TEST_ASSERT_EQUAL_UINT(BATCH_NUM_BODIES, batch_num_bodies(BATCH_ALL_BODIES));
+    TEST_ASSERT_EQUAL_UINT(2, batch_num_bodies(BATCH_BODY(MARS) | BATCH_BODY(BATCH_MOON)));
+}
+
+void test_batch_matches_scalar(void)
+{
+    check_batch(BATCH_ALL_BODIES & ~BATCH_BODY(EARTH), NULL);
+}
+
+void test_batch_subset(void)
+{
+    check_batch(BATCH_BODY(SUN) | BATCH_BODY(JUPITER) | BATCH_BODY(BATCH_MOON), NULL);
+}
+
+void test_batch_threaded(void)
+{
+    struct thread_pool pool;
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 4));
+    check_batch(BATCH_BODY(MERCURY) | BATCH_BODY(NEPTUNE) | BATCH_BODY(BATCH_MOON), &pool);
+    thread_pool_destroy(&pool);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_batch_num_bodies);
+    RUN_TEST(test_batch_matches_scalar);
+    RUN_TEST(test_batch_subset);
+    RUN_TEST(test_batch_threaded);
+
+    return UNITY_END();
+}
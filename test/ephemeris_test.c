@@ -0,0 +1,84 @@
+#include "ephemeris.h"
+#include "unity.h"
+
+#include "astro.h"
+#include "core.h"
+#include "data/keplerian_elements.h"
+
+#include <math.h>
+
+// Tolerance for positions in au, about 150 meters
+#define EPSILON 1.0E-9
+
+static struct arena arena;
+static struct planet *planet_table;
+
+void setUp(void)
+{
+    arena_init(&arena, 4096);
+    TEST_ASSERT_TRUE(generate_planet_table(&planet_table, planet_elements, planet_rates, planet_extras, &arena));
+}
+void tearDown(void)
+{
+    arena_destroy(&arena);
+}
+
+static void assert_matches_model(struct planet_ephemeris *ephemeris, enum planets planet, double julian_date)
+{
+    double x, y, z;
+    planet_ephemeris_helio_ICRF(ephemeris, planet, julian_date, &x, &y, &z);
+
+    double xm, ym, zm;
+    const struct planet *body = &planet_table[planet];
+    calc_planet_helio_ICRF(body->elements, body->rates, body->extras, julian_date, &xm, &ym, &zm);
+
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, xm, x);
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, ym, y);
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, zm, z);
+}
+
+void test_ephemeris_matches_model(void)
+{
+    struct planet_ephemeris ephemeris;
+    planet_ephemeris_init(&ephemeris, planet_table);
+
+    // A year of frames around J2000, covering Mercury's perihelion passages
+    for (double jd = 2451545.0; jd < 2451545.0 + 365.25; jd += 0.37)
+    {
+        for (int planet = SUN; planet < NUM_PLANETS; ++planet)
+        {
+            assert_matches_model(&ephemeris, planet, jd);
+        }
+    }
+}
+
+void test_ephemeris_refits_lazily(void)
+{
+    struct planet_ephemeris ephemeris;
+    planet_ephemeris_init(&ephemeris, planet_table);
+
+    double jd = 2460000.25;
+    assert_matches_model(&ephemeris, MARS, jd);
+    double segment_start = ephemeris.segment_start;
+    TEST_ASSERT_TRUE(segment_start <= jd && jd <= segment_start + EPHEMERIS_SEGMENT_DAYS);
+
+    // Later times within the segment reuse the fit
+    assert_matches_model(&ephemeris, MARS, segment_start + EPHEMERIS_SEGMENT_DAYS);
+    TEST_ASSERT_TRUE(ephemeris.segment_start == segment_start);
+
+    // Times before or after it are refitted, in either direction
+    assert_matches_model(&ephemeris, MARS, segment_start + EPHEMERIS_SEGMENT_DAYS + 0.5);
+    TEST_ASSERT_TRUE(ephemeris.segment_start == segment_start + EPHEMERIS_SEGMENT_DAYS);
+    assert_matches_model(&ephemeris, MARS, segment_start - 100.0);
+    assert_matches_model(&ephemeris, MARS, jd);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ephemeris_matches_model);
+    RUN_TEST(test_ephemeris_refits_lazily);
+
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+// POSIX clocks and signals
+#define _POSIX_C_SOURCE 200809L
+
+#include "event_loop.h"
+#include "unity.h"
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+static struct event_loop loop;
+static int input_fds[2];
+
+void setUp(void)
+{
+    TEST_ASSERT_EQUAL(0, pipe(input_fds));
+    TEST_ASSERT_TRUE(event_loop_init(&loop, input_fds[0]));
+}
+void tearDown(void)
+{
+    event_loop_free(&loop);
+    close(input_fds[0]);
+    close(input_fds[1]);
+}
+
+static double seconds_since(const struct timespec *begin)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - begin->tv_sec) + (now.tv_nsec - begin->tv_nsec) / 1.0E9;
+}
+
+static void sleep_usec(long microseconds)
+{
+    struct timespec duration = {microseconds / 1000000, (microseconds % 1000000) * 1000};
+    nanosleep(&duration, NULL);
+}
+
+void test_frame_waits_for_deadline(void)
+{
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    event_loop_schedule(&loop, 50000);
+    TEST_ASSERT_EQUAL(EVENT_FRAME, event_loop_wait(&loop));
+    TEST_ASSERT_TRUE(seconds_since(&begin) >= 0.05);
+}
+
+void test_deadlines_are_absolute(void)
+{
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    // Work done between frames does not push later frames back
+    for (int i = 0; i < 4; ++i)
+    {
+        sleep_usec(10000);
+        event_loop_schedule(&loop, 25000);
+        TEST_ASSERT_EQUAL(EVENT_FRAME, event_loop_wait(&loop));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 0.1, seconds_since(&begin));
+
+    // Simulated time follows the deadlines rather than when frames were drawn
+    TEST_ASSERT_FLOAT_WITHIN(1.0E-9, 0.1, event_loop_elapsed(&loop));
+}
+
+void test_missed_frames_are_dropped(void)
+{
+    sleep_usec(100000);
+
+    // The deadline passed long ago, so the frame is due now, and the one
+    // after it is a full interval later rather than also overdue
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    event_loop_schedule(&loop, 10000);
+    TEST_ASSERT_EQUAL(EVENT_FRAME, event_loop_wait(&loop));
+    TEST_ASSERT_TRUE(seconds_since(&begin) < 0.005);
+
+    event_loop_schedule(&loop, 50000);
+    TEST_ASSERT_EQUAL(EVENT_FRAME, event_loop_wait(&loop));
+    TEST_ASSERT_TRUE(seconds_since(&begin) >= 0.05);
+}
+
+void test_input_interrupts_wait(void)
+{
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    event_loop_schedule(&loop, 10000000);
+    TEST_ASSERT_EQUAL(1, write(input_fds[1], "q", 1));
+    TEST_ASSERT_EQUAL(EVENT_INPUT, event_loop_wait(&loop));
+    TEST_ASSERT_TRUE(seconds_since(&begin) < 1.0);
+}
+
+void test_resize_interrupts_wait(void)
+{
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    event_loop_schedule(&loop, 10000000);
+    raise(SIGWINCH);
+    TEST_ASSERT_EQUAL(EVENT_RESIZE, event_loop_wait(&loop));
+    TEST_ASSERT_TRUE(seconds_since(&begin) < 1.0);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_frame_waits_for_deadline);
+    RUN_TEST(test_deadlines_are_absolute);
+    RUN_TEST(test_missed_frames_are_dropped);
+    RUN_TEST(test_input_interrupts_wait);
+    RUN_TEST(test_resize_interrupts_wait);
+
+    return UNITY_END();
+}
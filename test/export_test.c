@@ -0,0 +1,160 @@
+#include "export.h"
+#include "unity.h"
+
+#include "core.h"
+#include "sky_fixture.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static struct sky_fixture sky;
+static FILE *output;
+
+void setUp(void)
+{
+    sky_fixture_init(&sky);
+
+    output = tmpfile();
+    TEST_ASSERT_NOT_NULL(output);
+}
+void tearDown(void)
+{
+    fclose(output);
+    sky_fixture_free(&sky);
+}
+
+/* Export `num_dates` hourly dates in `format` and return the output, which the
+ * caller must free
+ */
+static char *export_to_string(enum export_format format, unsigned long num_dates, long *length)
+{
+    struct export_writer writer;
+    TEST_ASSERT_TRUE(export_writer_init(&writer, fileno(output), format));
+    TEST_ASSERT_TRUE(export_positions(&writer, &sky.star_soa, sky.star_table, sky.planet_table, &sky.moon_object, NULL,
+                                      0.7, -1.2, 1.0, 2460000.5, 1.0 / 24.0, num_dates));
+    export_writer_free(&writer);
+
+    *length = lseek(fileno(output), 0, SEEK_CUR);
+    char *contents = malloc(*length + 1);
+    TEST_ASSERT_NOT_NULL(contents);
+    TEST_ASSERT_EQUAL_INT(*length, pread(fileno(output), contents, *length, 0));
+    contents[*length] = '\0';
+    return contents;
+}
+
+void test_export_csv(void)
+{
+    long length;
+    char *contents = export_to_string(EXPORT_CSV, 300, &length);
+
+    // A header, then every star, the Sun, the planets but the Earth, and the
+    // Moon at every date
+    int lines = 0;
+    for (long i = 0; i < length; ++i)
+    {
+        lines += contents[i] == '\n';
+    }
+    TEST_ASSERT_EQUAL_INT(1 + 300 * (SKY_FIXTURE_NUM_STARS + NUM_PLANETS), lines);
+
+    const char *header = "julian_date,object,right_ascension,declination,azimuth,altitude\n";
+    TEST_ASSERT_EQUAL_INT(0, strncmp(contents, header, strlen(header)));
+
+    // Stars are given by catalog number and keep their J2000 coordinates
+    const char *first = contents + strlen(header);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(first, "2460000.500000,1,0.000000,0.000000,", 35));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "\n2460000.500000,2,90.000000,0.000000,"));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "\n2460000.500000,Mars,"));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "\n2460000.500000,Moon,"));
+    TEST_ASSERT_NULL(strstr(contents, ",Earth,"));
+
+    free(contents);
+}
+
+void test_export_binary(void)
+{
+    long length;
+    char *contents = export_to_string(EXPORT_BINARY, 300, &length);
+
+    const unsigned int num_records = SKY_FIXTURE_NUM_STARS + NUM_PLANETS;
+    const long date_length = sizeof(double) + sizeof(uint32_t) + num_records * (sizeof(int32_t) + 4 * sizeof(float));
+    TEST_ASSERT_EQUAL_INT(8 + 300 * date_length, length);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(contents, EXPORT_BINARY_MAGIC, 8));
+
+    // Check the last date's header and its Moon record, which ends the file
+    const char *last = contents + 8 + 299 * date_length;
+    double julian_date;
+    uint32_t count;
+    memcpy(&julian_date, last, sizeof(julian_date));
+    memcpy(&count, last + sizeof(julian_date), sizeof(count));
+    TEST_ASSERT_FLOAT_WITHIN(1.0E-9, 2460000.5 + 299.0 / 24.0, julian_date);
+    TEST_ASSERT_EQUAL_UINT(num_records, count);
+
+    int32_t id;
+    memcpy(&id, contents + length - (sizeof(int32_t) + 4 * sizeof(float)), sizeof(id));
+    TEST_ASSERT_EQUAL_INT(EXPORT_MOON_ID, id);
+
+    free(contents);
+}
+
+void test_flush_waits_for_nonblocking_output(void)
+{
+    const size_t length = 1 << 18; // Well over the capacity of a pipe
+
+    int pipe_fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(pipe_fds));
+    TEST_ASSERT_EQUAL_INT(0, fcntl(pipe_fds[1], F_SETFL, O_NONBLOCK));
+
+    pid_t reader = fork();
+    TEST_ASSERT_TRUE(reader >= 0);
+    if (reader == 0)
+    {
+        // Leave the pipe full for a while before draining it
+        close(pipe_fds[1]);
+        usleep(200000);
+        char chunk[4096];
+        size_t total = 0;
+        ssize_t result;
+        while ((result = read(pipe_fds[0], chunk, sizeof(chunk))) > 0)
+        {
+            total += (size_t)result;
+        }
+        _exit(total == length + strlen(EXPORT_BINARY_MAGIC) ? 0 : 1);
+    }
+    close(pipe_fds[0]);
+
+    struct export_writer writer;
+    TEST_ASSERT_TRUE(export_writer_init(&writer, pipe_fds[1], EXPORT_BINARY));
+    memset(writer.buffer + writer.length, 0, length);
+    writer.length += length;
+
+    clock_t start = clock();
+    TEST_ASSERT_TRUE(export_writer_flush(&writer));
+    clock_t cpu_time = clock() - start;
+    export_writer_free(&writer);
+    close(pipe_fds[1]);
+
+    int status;
+    TEST_ASSERT_EQUAL_INT(reader, waitpid(reader, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+
+    // Waiting for the reader must not burn the CPU time it spent sleeping
+    TEST_ASSERT_TRUE(cpu_time < CLOCKS_PER_SEC / 20);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_export_csv);
+    RUN_TEST(test_export_binary);
+    RUN_TEST(test_flush_waits_for_nonblocking_output);
+
+    return UNITY_END();
+}
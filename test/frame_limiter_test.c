@@ -0,0 +1,65 @@
+#include "frame_limiter.h"
+#include "unity.h"
+
+// Tolerance for floating-point comparison
+#define EPSILON 1.0E-6
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+}
+
+void test_interval_without_budget(void)
+{
+    struct frame_limiter limiter;
+    frame_limiter_init(&limiter, 0.0, 1.0 / 24.0);
+
+    // Any amount of fast output keeps the requested frame rate
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, 1.0 / 24.0, frame_limiter_update(&limiter, 1000000, 0.0));
+}
+
+void test_interval_stays_under_budget(void)
+{
+    struct frame_limiter limiter;
+    frame_limiter_init(&limiter, 1000.0, 0.1);
+
+    // Small frames are sent at the requested frame rate
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, 0.1, frame_limiter_update(&limiter, 50, 0.0));
+
+    // A 500 byte frame takes half a second at 1000 bytes per second
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, 0.5, frame_limiter_update(&limiter, 500, 0.0));
+}
+
+void test_interval_backs_off_slow_writes(void)
+{
+    struct frame_limiter limiter;
+    frame_limiter_init(&limiter, 0.0, 0.1);
+
+    // Writes consistently taking 0.2 seconds push frames 0.4 seconds apart
+    double interval = 0.0;
+    for (int i = 0; i < 100; ++i)
+    {
+        interval = frame_limiter_update(&limiter, 100, 0.2);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, 0.4, interval);
+
+    // And recover once writes are fast again
+    for (int i = 0; i < 100; ++i)
+    {
+        interval = frame_limiter_update(&limiter, 100, 0.0);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(EPSILON, 0.1, interval);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_interval_without_budget);
+    RUN_TEST(test_interval_stays_under_budget);
+    RUN_TEST(test_interval_backs_off_slow_writes);
+
+    return UNITY_END();
+}
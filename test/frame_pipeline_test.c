@@ -0,0 +1,107 @@
+#include "frame_pipeline.h"
+#include "unity.h"
+
+#include "core.h"
+#include "ephemeris.h"
+#include "sky_fixture.h"
+
+#include <math.h>
+#include <unistd.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Seconds after which a test that has not finished is deemed deadlocked
+#define TIMEOUT 10
+
+#define JULIAN_DATE 2460000.5
+#define JULIAN_STEP (1.0 / 24.0)
+
+static struct sky_fixture sky;
+static struct sky_index sky_index;
+static struct planet_ephemeris ephemeris;
+static struct conf config;
+
+void setUp(void)
+{
+    // A deadlock ends the test run rather than hanging it
+    alarm(TIMEOUT);
+
+    sky_fixture_init(&sky);
+    planet_ephemeris_init(&ephemeris, sky.planet_table);
+    TEST_ASSERT_TRUE(generate_sky_index(&sky_index, &sky.star_soa, NULL, 0, &sky.arena));
+
+    config = (struct conf){
+        .latitude = 0.7,
+        .longitude = -1.3,
+        .julian_date = JULIAN_DATE,
+        .pm_interval = 365.25,
+    };
+}
+void tearDown(void)
+{
+    sky_fixture_free(&sky);
+    alarm(0);
+}
+
+void test_buffers_hold_requested_dates(void)
+{
+    struct frame_pipeline pipeline;
+    TEST_ASSERT_TRUE(frame_pipeline_start(&pipeline, &sky.star_soa, &sky_index, NULL, &ephemeris, &sky.moon_object, &config,
+                                          JULIAN_STEP));
+
+    // The first two frames are at the start date and one step later, and each
+    // released buffer is filled for the date it was released with
+    const struct frame_positions *previous = NULL;
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        const struct frame_positions *positions = frame_pipeline_acquire(&pipeline);
+        TEST_ASSERT_FLOAT_WITHIN(1.0E-9, JULIAN_DATE + frame * JULIAN_STEP, positions->julian_date);
+
+        // The two buffers take turns
+        TEST_ASSERT_TRUE(positions != previous);
+        previous = positions;
+
+        TEST_ASSERT_TRUE(-M_PI / 2 <= positions->moon_altitude && positions->moon_altitude <= M_PI / 2);
+
+        frame_pipeline_release(&pipeline, JULIAN_DATE + (frame + 2) * JULIAN_STEP);
+    }
+
+    frame_pipeline_stop(&pipeline);
+}
+
+void test_stop_while_compute_thread_waits(void)
+{
+    struct frame_pipeline pipeline;
+    TEST_ASSERT_TRUE(frame_pipeline_start(&pipeline, &sky.star_soa, &sky_index, NULL, &ephemeris, &sky.moon_object, &config,
+                                          JULIAN_STEP));
+
+    // Once both buffers are full the compute thread sleeps until one is
+    // released, and must wake up to be joined
+    frame_pipeline_acquire(&pipeline);
+    usleep(100000);
+
+    frame_pipeline_stop(&pipeline);
+}
+
+void test_stop_right_after_start(void)
+{
+    // The compute thread may still be computing the first frames, or may not
+    // have started yet
+    struct frame_pipeline pipeline;
+    TEST_ASSERT_TRUE(frame_pipeline_start(&pipeline, &sky.star_soa, &sky_index, NULL, &ephemeris, &sky.moon_object, &config,
+                                          JULIAN_STEP));
+    frame_pipeline_stop(&pipeline);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_buffers_hold_requested_dates);
+    RUN_TEST(test_stop_while_compute_thread_waits);
+    RUN_TEST(test_stop_right_after_start);
+
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+#include "parse_BSC5.h"
+#include "unity.h"
+
+#include "arena.h"
+#include "core.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HEADER_BYTES 28
+#define ENTRY_BYTES 32
+#define NUM_ENTRIES 2
+
+static uint8_t catalog[HEADER_BYTES + NUM_ENTRIES * ENTRY_BYTES];
+
+static void put_int32(uint8_t *buffer, int32_t value)
+{
+    uint32_t bits = (uint32_t)value;
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer[i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+/* Write a BSC5 header with the given fields
+ */
+static void put_header(int starn, int stnum, int mprop, int nmag, int nbent)
+{
+    put_int32(&catalog[0], 0);
+    put_int32(&catalog[4], 1);
+    put_int32(&catalog[8], starn);
+    put_int32(&catalog[12], stnum);
+    put_int32(&catalog[16], mprop);
+    put_int32(&catalog[20], nmag);
+    put_int32(&catalog[24], nbent);
+}
+
+void setUp(void)
+{
+    memset(catalog, 0, sizeof(catalog));
+    put_header(-NUM_ENTRIES, 1, 1, 1, ENTRY_BYTES);
+
+    // Magnitude of the second entry, in hundredths
+    catalog[HEADER_BYTES + ENTRY_BYTES + 22] = 250;
+}
+void tearDown(void)
+{
+}
+
+void test_bsc5_view_init_accepts_bsc5_layout(void)
+{
+    struct bsc5_view view;
+    TEST_ASSERT_TRUE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+    TEST_ASSERT_EQUAL_UINT(NUM_ENTRIES, view.num_entries);
+    TEST_ASSERT_FLOAT_WITHIN(1.0E-6f, 2.5f, bsc5_view_magnitude(&view, 1));
+}
+
+void test_bsc5_view_init_rejects_short_data(void)
+{
+    struct bsc5_view view;
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, HEADER_BYTES - 1));
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog) - 1));
+}
+
+void test_bsc5_view_init_rejects_other_layouts(void)
+{
+    struct bsc5_view view;
+
+    put_header(-NUM_ENTRIES, 1, 1, 1, 36);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+
+    put_header(-NUM_ENTRIES, 0, 1, 1, ENTRY_BYTES);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+
+    put_header(-NUM_ENTRIES, 1, 2, 1, ENTRY_BYTES);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+
+    put_header(-NUM_ENTRIES, 1, 1, 2, ENTRY_BYTES);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+}
+
+void test_bsc5_view_init_rejects_b1950_and_bad_counts(void)
+{
+    struct bsc5_view view;
+
+    // Positive counts mean B1950 coordinates
+    put_header(NUM_ENTRIES, 1, 1, 1, ENTRY_BYTES);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+
+    put_header(0, 1, 1, 1, ENTRY_BYTES);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+
+    put_header(INT_MIN, 1, 1, 1, ENTRY_BYTES);
+    TEST_ASSERT_FALSE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+}
+
+void test_magnitudes_beyond_bsc5_get_valid_symbols(void)
+{
+    // Catalogs loaded with --catalog can hold stars fainter than any in BSC5
+    // and brighter than Sirius
+    const int16_t magnitudes[NUM_ENTRIES] = {1200, -200};
+    for (int i = 0; i < NUM_ENTRIES; ++i)
+    {
+        uint16_t bits = (uint16_t)magnitudes[i];
+        catalog[HEADER_BYTES + i * ENTRY_BYTES + 22] = (uint8_t)bits;
+        catalog[HEADER_BYTES + i * ENTRY_BYTES + 23] = (uint8_t)(bits >> 8);
+    }
+
+    struct bsc5_view view;
+    TEST_ASSERT_TRUE(bsc5_view_init(&view, catalog, sizeof(catalog)));
+
+    struct arena arena;
+    arena_init(&arena, 4096);
+
+    struct packed_star *packed_table;
+    unsigned int num_stars;
+    TEST_ASSERT_TRUE(generate_bright_packed_star_table(&packed_table, &num_stars, &view, 20.0f, &arena));
+    TEST_ASSERT_EQUAL_UINT(NUM_ENTRIES, num_stars);
+
+    struct star *star_table;
+    TEST_ASSERT_TRUE(generate_star_table(&star_table, packed_table, num_stars, &arena));
+
+    // The faintest and brightest symbols
+    TEST_ASSERT_EQUAL_UINT(9, packed_table[0].symbol);
+    TEST_ASSERT_EQUAL_CHAR('.', star_table[0].base.symbol_ASCII);
+    TEST_ASSERT_EQUAL_STRING("⋅", star_table[0].base.symbol_unicode);
+
+    TEST_ASSERT_EQUAL_UINT(0, packed_table[1].symbol);
+    TEST_ASSERT_EQUAL_CHAR('0', star_table[1].base.symbol_ASCII);
+    TEST_ASSERT_EQUAL_STRING("⬤", star_table[1].base.symbol_unicode);
+
+    arena_destroy(&arena);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bsc5_view_init_accepts_bsc5_layout);
+    RUN_TEST(test_bsc5_view_init_rejects_short_data);
+    RUN_TEST(test_bsc5_view_init_rejects_other_layouts);
+    RUN_TEST(test_bsc5_view_init_rejects_b1950_and_bad_counts);
+    RUN_TEST(test_magnitudes_beyond_bsc5_get_valid_symbols);
+
+    return UNITY_END();
+}
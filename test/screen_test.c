@@ -0,0 +1,184 @@
+#include "screen.h"
+#include "unity.h"
+
+#include <locale.h>
+#include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#define HEIGHT 3
+#define WIDTH 8
+
+static FILE *terminal_output;
+static FILE *terminal_input;
+static SCREEN *terminal;
+static FILE *vt_output;
+
+void setUp(void)
+{
+    if (setlocale(LC_ALL, "C.UTF-8") == NULL && setlocale(LC_ALL, "en_US.UTF-8") == NULL)
+    {
+        TEST_IGNORE_MESSAGE("No UTF-8 locale available");
+    }
+
+    // Curses only needs a terminal description, output goes to a file
+    terminal_output = tmpfile();
+    terminal_input = tmpfile();
+    terminal = newterm("xterm", terminal_output, terminal_input);
+    TEST_ASSERT_NOT_NULL(terminal);
+
+    vt_output = tmpfile();
+    TEST_ASSERT_NOT_NULL(vt_output);
+}
+void tearDown(void)
+{
+    if (terminal != NULL)
+    {
+        endwin();
+        delscreen(terminal);
+        terminal = NULL;
+        fclose(terminal_output);
+        fclose(terminal_input);
+        fclose(vt_output);
+    }
+}
+
+/* Present the canvas as VT output and return what was written, which is valid
+ * until the next call
+ */
+static const char *present_vt(struct screen *screen, WINDOW *win)
+{
+    static char contents[4096];
+
+    int fd = fileno(vt_output);
+    TEST_ASSERT_EQUAL_INT(0, ftruncate(fd, 0));
+    lseek(fd, 0, SEEK_SET);
+
+    size_t written = screen_present_vt(screen, win, fd);
+    TEST_ASSERT_TRUE(written < sizeof(contents));
+    TEST_ASSERT_EQUAL_INT((int)written, pread(fd, contents, written, 0));
+    contents[written] = '\0';
+
+    return contents;
+}
+
+void test_wide_glyph_moves_by_one_column(void)
+{
+    WINDOW *win = newwin(HEIGHT, WIDTH, 0, 0);
+    struct screen screen;
+    TEST_ASSERT_TRUE(screen_init(&screen, HEIGHT, WIDTH, true));
+
+    WINDOW *canvas = screen_begin_frame(&screen);
+    mvwaddwstr(canvas, 1, 2, L"🌕");
+    present_vt(&screen, win);
+
+    canvas = screen_begin_frame(&screen);
+    mvwaddwstr(canvas, 1, 3, L"🌕");
+    const char *output = present_vt(&screen, win);
+
+    // A blank over the old glyph, then the glyph at its new position
+    TEST_ASSERT_EQUAL_STRING("\033[2;3H 🌕", output);
+
+    // Moving back, the cell the glyph covered is blanked again
+    canvas = screen_begin_frame(&screen);
+    mvwaddwstr(canvas, 1, 2, L"🌕");
+    output = present_vt(&screen, win);
+    TEST_ASSERT_EQUAL_STRING("\033[2;3H🌕\033[2;5H ", output);
+
+    screen_free(&screen);
+    delwin(win);
+}
+
+void test_full_redraw_on_first_frame_and_resize(void)
+{
+    WINDOW *win = newwin(HEIGHT, WIDTH, 0, 0);
+    struct screen screen;
+    TEST_ASSERT_TRUE(screen_init(&screen, HEIGHT, WIDTH, true));
+
+    // Every cell is written after blanking the terminal
+    WINDOW *canvas = screen_begin_frame(&screen);
+    mvwaddstr(canvas, 0, 0, "ab");
+    const char *output = present_vt(&screen, win);
+    TEST_ASSERT_EQUAL_STRING("\033[0m\033[2J\033[1;1Hab      \033[2;1H        \033[3;1H        ", output);
+
+    // An unchanged frame writes nothing
+    canvas = screen_begin_frame(&screen);
+    mvwaddstr(canvas, 0, 0, "ab");
+    output = present_vt(&screen, win);
+    TEST_ASSERT_EQUAL_STRING("", output);
+
+    TEST_ASSERT_TRUE(screen_resize(&screen, 1, 2));
+    canvas = screen_begin_frame(&screen);
+    mvwaddstr(canvas, 0, 0, "ab");
+    output = present_vt(&screen, win);
+    TEST_ASSERT_EQUAL_STRING("\033[0m\033[2J\033[1;1Hab", output);
+
+    screen_free(&screen);
+    delwin(win);
+}
+
+void test_cursor_moves_are_coalesced(void)
+{
+    WINDOW *win = newwin(HEIGHT, WIDTH, 0, 0);
+    struct screen screen;
+    TEST_ASSERT_TRUE(screen_init(&screen, HEIGHT, WIDTH, true));
+
+    screen_begin_frame(&screen);
+    present_vt(&screen, win);
+
+    WINDOW *canvas = screen_begin_frame(&screen);
+    mvwaddstr(canvas, 0, 1, "xy");
+    mvwaddstr(canvas, 0, 5, "z");
+    mvwaddstr(canvas, 0, 7, "w");
+    mvwaddstr(canvas, 2, 0, "v");
+    const char *output = present_vt(&screen, win);
+
+    // No move between adjacent cells, relative moves forward along a row
+    TEST_ASSERT_EQUAL_STRING("\033[1;2Hxy\033[2Cz\033[Cw\033[3;1Hv", output);
+
+    screen_free(&screen);
+    delwin(win);
+}
+
+void test_colors_only_set_when_changed(void)
+{
+    TEST_ASSERT_EQUAL_INT(OK, start_color());
+    TEST_ASSERT_EQUAL_INT(OK, init_pair(1, COLOR_RED, COLOR_BLACK));
+
+    WINDOW *win = newwin(HEIGHT, WIDTH, 0, 0);
+    struct screen screen;
+    TEST_ASSERT_TRUE(screen_init(&screen, HEIGHT, WIDTH, true));
+
+    screen_begin_frame(&screen);
+    present_vt(&screen, win);
+
+    WINDOW *canvas = screen_begin_frame(&screen);
+    wattron(canvas, COLOR_PAIR(1));
+    mvwaddstr(canvas, 0, 0, "ab");
+    wattroff(canvas, COLOR_PAIR(1));
+    mvwaddstr(canvas, 0, 3, "c");
+    wattron(canvas, COLOR_PAIR(1) | A_BOLD);
+    mvwaddstr(canvas, 1, 0, "d");
+    const char *output = present_vt(&screen, win);
+
+    // Default colors are restored at the end of the frame
+    TEST_ASSERT_EQUAL_STRING("\033[1;1H\033[0;31mab\033[C\033[0mc\033[2;1H\033[0;1;31md\033[0m", output);
+
+    screen_free(&screen);
+    delwin(win);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_wide_glyph_moves_by_one_column);
+    RUN_TEST(test_full_redraw_on_first_frame_and_resize);
+    RUN_TEST(test_cursor_moves_are_coalesced);
+    RUN_TEST(test_colors_only_set_when_changed);
+
+    return UNITY_END();
+}
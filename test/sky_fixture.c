@@ -0,0 +1,27 @@
+#include "sky_fixture.h"
+#include "unity.h"
+
+#include "arena.h"
+#include "core.h"
+#include "data/keplerian_elements.h"
+
+void sky_fixture_init(struct sky_fixture *sky)
+{
+    static const struct packed_star packed_table[SKY_FIXTURE_NUM_STARS] = {
+        {0u, 0, 0, 0, 100, 0},
+        {1073741824u, 0, 0, 0, 200, 0},
+        {2147483648u, 0, 0, 0, 300, 0},
+    };
+    static const int star_numbers[SKY_FIXTURE_NUM_STARS] = {1, 2, 3};
+
+    arena_init(&sky->arena, 4096);
+    TEST_ASSERT_TRUE(generate_planet_table(&sky->planet_table, planet_elements, planet_rates, planet_extras, &sky->arena));
+    TEST_ASSERT_TRUE(generate_moon_object(&sky->moon_object, &moon_elements, &moon_rates));
+    TEST_ASSERT_TRUE(generate_star_table(&sky->star_table, packed_table, SKY_FIXTURE_NUM_STARS, &sky->arena));
+    TEST_ASSERT_TRUE(generate_star_soa(&sky->star_soa, packed_table, star_numbers, SKY_FIXTURE_NUM_STARS, &sky->arena));
+}
+
+void sky_fixture_free(struct sky_fixture *sky)
+{
+    arena_destroy(&sky->arena);
+}
@@ -0,0 +1,29 @@
+/* Small sky shared by tests that compute positions: the Sun, planets and Moon,
+ * and three stars on the celestial equator at 0h, 6h and 12h with catalog
+ * numbers 1 to 3. Everything is allocated from the fixture's arena
+ */
+
+#ifndef SKY_FIXTURE_H
+#define SKY_FIXTURE_H
+
+#include "arena.h"
+#include "core.h"
+
+#define SKY_FIXTURE_NUM_STARS 3
+
+struct sky_fixture
+{
+    struct arena arena;
+    struct planet *planet_table;
+    struct moon moon_object;
+    struct star *star_table;
+    struct star_soa star_soa;
+};
+
+/* Build the fixture, failing the running test upon error
+ */
+void sky_fixture_init(struct sky_fixture *sky);
+
+void sky_fixture_free(struct sky_fixture *sky);
+
+#endif // SKY_FIXTURE_H
@@ -0,0 +1,151 @@
+#include "thread_pool.h"
+#include "unity.h"
+
+#include <stdlib.h>
+
+#define MAX_THREADS 8
+
+// Times each index was visited by the current job
+struct visits
+{
+    unsigned int *counts;
+    unsigned int num_calls; // Number of ranges handed out
+    unsigned int num_empty; // Ranges with no indices, which should never be handed out
+};
+
+static void count_visits(void *arg, unsigned int begin, unsigned int end)
+{
+    struct visits *visits = arg;
+
+    // Test assertions can only fail on the thread running the test, so
+    // results are checked once the job is done
+    __atomic_fetch_add(&visits->num_calls, 1, __ATOMIC_RELAXED);
+    if (begin >= end)
+    {
+        __atomic_fetch_add(&visits->num_empty, 1, __ATOMIC_RELAXED);
+    }
+
+    // Ranges are disjoint, so an atomic increment only matters if they aren't
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        __atomic_fetch_add(&visits->counts[i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* Run a job over [0, count) and check that each index was visited exactly once.
+ * Returns the number of ranges the job was split into
+ */
+static unsigned int run_and_check(struct thread_pool *pool, unsigned int count)
+{
+    struct visits visits = {.counts = calloc(count + 1, sizeof(unsigned int)), .num_calls = 0, .num_empty = 0};
+    TEST_ASSERT_NOT_NULL(visits.counts);
+
+    thread_pool_run(pool, count_visits, &visits, count);
+
+    // thread_pool_run only returns once every chunk has finished
+    TEST_ASSERT_EQUAL_UINT(0, visits.num_empty);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT(1, __atomic_load_n(&visits.counts[i], __ATOMIC_RELAXED));
+    }
+
+    free(visits.counts);
+    return visits.num_calls;
+}
+
+void setUp(void)
+{
+}
+void tearDown(void)
+{
+}
+
+void test_every_index_visited_once(void)
+{
+    const unsigned int counts[] = {1, 2, 3, 7, 31, 32, 33, 1000, 100003};
+
+    for (unsigned int num_threads = 1; num_threads <= MAX_THREADS; ++num_threads)
+    {
+        struct thread_pool pool;
+        TEST_ASSERT_TRUE(thread_pool_init(&pool, num_threads));
+
+        for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+        {
+            run_and_check(&pool, counts[c]);
+        }
+
+        thread_pool_destroy(&pool);
+    }
+}
+
+void test_many_small_jobs(void)
+{
+    // Workers must pick up each new job once and only once, even when jobs
+    // follow each other faster than they wake up
+    struct thread_pool pool;
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 4));
+
+    for (unsigned int job = 0; job < 10000; ++job)
+    {
+        run_and_check(&pool, 1 + job % 64);
+    }
+
+    thread_pool_destroy(&pool);
+}
+
+void test_chunking(void)
+{
+    struct thread_pool pool;
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 4));
+
+    // Jobs are split into a few chunks per thread
+    TEST_ASSERT_EQUAL_UINT(16, run_and_check(&pool, 1600));
+    TEST_ASSERT_EQUAL_UINT(16, run_and_check(&pool, 1601));
+
+    // Small jobs get one index per chunk
+    TEST_ASSERT_EQUAL_UINT(5, run_and_check(&pool, 5));
+
+    thread_pool_destroy(&pool);
+}
+
+void test_single_thread_runs_on_caller(void)
+{
+    // With no workers the caller runs the whole range in one call
+    struct thread_pool pool;
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 1));
+    TEST_ASSERT_EQUAL_UINT(1, run_and_check(&pool, 1000));
+    thread_pool_destroy(&pool);
+
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 0));
+    TEST_ASSERT_EQUAL_UINT(1, pool.num_threads);
+    thread_pool_destroy(&pool);
+
+    TEST_ASSERT_EQUAL_UINT(1, run_and_check(NULL, 1000));
+}
+
+void test_empty_job(void)
+{
+    struct thread_pool pool;
+    TEST_ASSERT_TRUE(thread_pool_init(&pool, 4));
+
+    // The task is never called for an empty range, and the pool still runs
+    // later jobs
+    TEST_ASSERT_EQUAL_UINT(0, run_and_check(&pool, 0));
+    TEST_ASSERT_EQUAL_UINT(0, run_and_check(NULL, 0));
+    run_and_check(&pool, 100);
+
+    thread_pool_destroy(&pool);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_every_index_visited_once);
+    RUN_TEST(test_many_small_jobs);
+    RUN_TEST(test_chunking);
+    RUN_TEST(test_single_thread_runs_on_caller);
+    RUN_TEST(test_empty_job);
+
+    return UNITY_END();
+}